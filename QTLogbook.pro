@@ -8,12 +8,27 @@ TEMPLATE = app
 # Definizioni del preprocessore
 DEFINES += QT_DEPRECATED_WARNINGS QT_DISABLE_DEPRECATED_BEFORE=0x060000
 
+# SQLite di sistema per l'API di backup online (sqlite3_backup_*)
+LIBS += -lsqlite3
+
 # File sorgenti
 SOURCES += \
     src/main.cpp \
     src/mainwindow.cpp \
     src/contact.cpp \
+    src/contactquery.cpp \
+    src/compactcontact.cpp \
+    src/dupeindex.cpp \
     src/database.cpp \
+    src/asyncdatabase.cpp \
+    src/databasereadpool.cpp \
+    src/databasebackup.cpp \
+    src/queryprofiler.cpp \
+    src/maidenhead.cpp \
+    src/qsowritequeue.cpp \
+    src/supercheckpartial.cpp \
+    src/awardtracker.cpp \
+    src/awardmatrixmodel.cpp \
     src/apiservice.cpp \
     src/logbookmodel.cpp \
     src/setupdialog.cpp \
@@ -24,7 +39,19 @@ SOURCES += \
 HEADERS += \
     src/mainwindow.h \
     src/contact.h \
+    src/contactquery.h \
+    src/compactcontact.h \
+    src/dupeindex.h \
     src/database.h \
+    src/asyncdatabase.h \
+    src/databasereadpool.h \
+    src/databasebackup.h \
+    src/queryprofiler.h \
+    src/maidenhead.h \
+    src/qsowritequeue.h \
+    src/supercheckpartial.h \
+    src/awardtracker.h \
+    src/awardmatrixmodel.h \
     src/apiservice.h \
     src/logbookmodel.h \
     src/setupdialog.h \
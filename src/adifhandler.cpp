@@ -13,7 +13,7 @@ ADIFHandler::ADIFHandler()
     initializeModeMappings();
 }
 
-ADIFHandler::ImportResult ADIFHandler::importFromFile(const QString &filePath, const QList<Contact> &existingContacts)
+ADIFHandler::ImportResult ADIFHandler::importFromFile(const QString &filePath, const QList<CompactContact> &existingContacts)
 {
     ImportResult result;
     
@@ -314,16 +314,23 @@ QDateTime ADIFHandler::parseADIFDateTime(const QString &date, const QString &tim
     return QDateTime::fromString(dateTimeStr, "yyyyMMddHHmmss").toUTC();
 }
 
-bool ADIFHandler::isDuplicate(const Contact &contact, const QList<Contact> &existingContacts)
+bool ADIFHandler::isDuplicate(const Contact &contact, const QList<CompactContact> &existingContacts)
 {
     // Un contatto è considerato duplicato se ha stesso nominativo, banda, modo e data/ora entro 5 minuti
-    for (const Contact &existing : existingContacts) {
-        if (existing.callsign() == contact.callsign() &&
-            existing.band() == contact.band() &&
-            existing.mode() == contact.mode()) {
+    // Confronto sui record compatti: id internati e byte del nominativo, nessuna stringa
+    const CompactContact candidate(contact);
+    for (const CompactContact &existing : existingContacts) {
+        if (existing.bandId() == candidate.bandId() &&
+            existing.modeId() == candidate.modeId() &&
+            existing.hasSameCallsign(candidate)) {
+            
+            // Data/ora non valida: come QDateTime::secsTo, differenza nulla
+            if (!existing.hasDateTime() || !candidate.hasDateTime()) {
+                return true;
+            }
             
             // Verifica differenza temporale (entro 5 minuti)
-            qint64 timeDiff = qAbs(existing.dateTime().secsTo(contact.dateTime()));
+            qint64 timeDiff = qAbs(existing.utcEpoch() - candidate.utcEpoch());
             if (timeDiff <= 300) { // 5 minuti = 300 secondi
                 return true;
             }
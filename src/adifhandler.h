@@ -8,6 +8,7 @@
 #include <QFile>
 #include <QMap>
 #include "contact.h"
+#include "compactcontact.h"
 
 class ADIFHandler
 {
@@ -32,7 +33,7 @@ public:
     ADIFHandler();
     
     // Importazione ADIF
-    ImportResult importFromFile(const QString &filePath, const QList<Contact> &existingContacts);
+    ImportResult importFromFile(const QString &filePath, const QList<CompactContact> &existingContacts);
     
     // Esportazione ADIF
     ExportResult exportToFile(const QString &filePath, const QList<Contact> &contacts, const QString &operatorCall = QString());
@@ -62,7 +63,7 @@ private:
     QString formatADIFField(const QString &fieldName, const QString &value);
     QString formatADIFDateTime(const QDateTime &dateTime);
     QDateTime parseADIFDateTime(const QString &date, const QString &time);
-    bool isDuplicate(const Contact &contact, const QList<Contact> &existingContacts);
+    bool isDuplicate(const Contact &contact, const QList<CompactContact> &existingContacts);
     
     // Mappature bande/frequenze
     void initializeBandMappings();
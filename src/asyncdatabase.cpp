@@ -0,0 +1,290 @@
+#include "asyncdatabase.h"
+#include <QtCore/QMutexLocker>
+#include <QtCore/QDebug>
+
+AsyncDatabase::AsyncDatabase(const QString &databasePath, QObject *parent)
+    : QObject(parent)
+    , m_databasePath(databasePath)
+    , m_connectionName(QString("qtlogbook_async_%1").arg(quintptr(this), 0, 16))
+    , m_thread(nullptr)
+    , m_readPool(new DatabaseReadPool(databasePath))
+{
+    m_thread = QThread::create([this] { workerLoop(); });
+    m_thread->setObjectName("DatabaseThread");
+    m_thread->start();
+}
+
+AsyncDatabase::~AsyncDatabase()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+    }
+    m_condition.wakeAll();
+    
+    // Le richieste già accodate (es. scritture) vengono completate prima dell'uscita
+    m_thread->wait();
+    delete m_thread;
+    
+    m_readPool.reset();
+}
+
+QFuture<Contact> AsyncDatabase::addContact(const Contact &contact, Priority priority)
+{
+    return run<Contact>(priority, [this, contact](Database &database) {
+        Contact inserted = contact;
+        if (!database.addContact(inserted)) {
+            emit requestFailed(database.lastError());
+        }
+        return inserted;
+    });
+}
+
+QFuture<int> AsyncDatabase::addContacts(const QList<Contact> &contacts, const QString &importSource,
+                                        Priority priority)
+{
+    return run<int>(priority, [this, contacts, importSource](Database &database) {
+        QList<Contact> batch = contacts;
+        const int added = database.addContacts(batch, importSource);
+        if (added < batch.size()) {
+            emit requestFailed(database.lastError());
+        }
+        return added;
+    });
+}
+
+QFuture<bool> AsyncDatabase::updateContact(const Contact &contact, Priority priority)
+{
+    return run<bool>(priority, [this, contact](Database &database) {
+        const bool ok = database.updateContact(contact);
+        if (!ok) {
+            emit requestFailed(database.lastError());
+        }
+        return ok;
+    });
+}
+
+QFuture<bool> AsyncDatabase::deleteContact(int contactId, Priority priority)
+{
+    return run<bool>(priority, [this, contactId](Database &database) {
+        const bool ok = database.deleteContact(contactId);
+        if (!ok) {
+            emit requestFailed(database.lastError());
+        }
+        return ok;
+    });
+}
+
+QFuture<bool> AsyncDatabase::deleteContacts(const QList<int> &contactIds, Priority priority)
+{
+    return run<bool>(priority, [this, contactIds](Database &database) {
+        const bool ok = database.deleteContacts(contactIds);
+        if (!ok) {
+            emit requestFailed(database.lastError());
+        }
+        return ok;
+    });
+}
+
+QFuture<bool> AsyncDatabase::updateField(const QList<int> &contactIds, Database::ContactField field,
+                                         const QString &value, Priority priority)
+{
+    return run<bool>(priority, [this, contactIds, field, value](Database &database) {
+        const bool ok = database.updateField(contactIds, field, value);
+        if (!ok) {
+            emit requestFailed(database.lastError());
+        }
+        return ok;
+    });
+}
+
+QFuture<bool> AsyncDatabase::deleteImportBatch(qint64 importBatch, Priority priority)
+{
+    return run<bool>(priority, [this, importBatch](Database &database) {
+        const bool ok = database.deleteImportBatch(importBatch);
+        if (!ok) {
+            emit requestFailed(database.lastError());
+        }
+        return ok;
+    });
+}
+
+QFuture<Contact> AsyncDatabase::getContact(int contactId, Priority priority)
+{
+    return read<Contact>(priority, [contactId](Database &database) {
+        return database.getContact(contactId);
+    });
+}
+
+QFuture<QList<Contact>> AsyncDatabase::getAllContacts(Priority priority)
+{
+    return read<QList<Contact>>(priority, [](Database &database) {
+        return database.getAllContacts();
+    });
+}
+
+QFuture<QList<CompactContact>> AsyncDatabase::getAllCompactContacts(Priority priority)
+{
+    return read<QList<CompactContact>>(priority, [](Database &database) {
+        return database.getAllCompactContacts();
+    });
+}
+
+QFuture<QList<Contact>> AsyncDatabase::searchContacts(const QString &searchTerm, Priority priority)
+{
+    return read<QList<Contact>>(priority, [searchTerm](Database &database) {
+        return database.searchContacts(searchTerm);
+    });
+}
+
+QFuture<int> AsyncDatabase::archiveContactsBefore(int cutoffYear, Priority priority)
+{
+    return run<int>(priority, [this, cutoffYear](Database &database) {
+        const int moved = database.archiveContactsBefore(cutoffYear);
+        if (moved < 0) {
+            emit requestFailed(database.lastError());
+        }
+        return moved;
+    });
+}
+
+QFuture<bool> AsyncDatabase::setOperatorData(const Database::OperatorData &data, Priority priority)
+{
+    return run<bool>(priority, [this, data](Database &database) {
+        const bool ok = database.setOperatorData(data.callsign, data.firstName, data.lastName, data.locator);
+        if (!ok) {
+            emit requestFailed(database.lastError());
+        }
+        return ok;
+    });
+}
+
+QFuture<int> AsyncDatabase::backfillEpochs()
+{
+    auto promise = std::make_shared<QPromise<int>>();
+    QFuture<int> future = promise->future();
+    promise->start();
+    
+    enqueueBackfillBatch(promise, 0);
+    return future;
+}
+
+QFuture<int> AsyncDatabase::compactDatabase()
+{
+    auto promise = std::make_shared<QPromise<int>>();
+    QFuture<int> future = promise->future();
+    promise->start();
+    
+    enqueueCompactionStep(promise, 0);
+    return future;
+}
+
+int AsyncDatabase::pendingRequests() const
+{
+    QMutexLocker locker(&m_mutex);
+    return int(m_queue.size());
+}
+
+DatabaseReadPool::Metrics AsyncDatabase::readPoolMetrics() const
+{
+    return m_readPool->metrics();
+}
+
+void AsyncDatabase::enqueue(Priority priority, std::function<void(Database &)> task)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queue.push({priority, m_nextSequence++, std::move(task)});
+    }
+    m_condition.wakeOne();
+}
+
+void AsyncDatabase::enqueueBackfillBatch(std::shared_ptr<QPromise<int>> promise, int converted)
+{
+    // Un lotto per richiesta: tra un lotto e l'altro passano le richieste
+    // con priorità più alta (inserimento QSO, caricamenti)
+    enqueue(BackgroundPriority, [this, promise, converted](Database &database) {
+        const int batch = database.backfillEpochBatch();
+        if (batch < 0) {
+            emit requestFailed(database.lastError());
+        }
+        
+        bool stopping;
+        {
+            QMutexLocker locker(&m_mutex);
+            stopping = m_stopping;
+        }
+        
+        if (batch > 0 && !stopping) {
+            enqueueBackfillBatch(promise, converted + batch);
+            return;
+        }
+        
+        promise->addResult(converted + qMax(batch, 0));
+        promise->finish();
+    });
+}
+
+void AsyncDatabase::enqueueCompactionStep(std::shared_ptr<QPromise<int>> promise, int freed)
+{
+    // Come il backfill: un passo per richiesta, le scritture interattive
+    // passano avanti. Manutenzione in background: errori solo nel log
+    enqueue(BackgroundPriority, [this, promise, freed](Database &database) {
+        const int step = database.incrementalVacuumStep();
+        if (step < 0) {
+            qWarning() << "Compattazione database:" << database.lastError();
+        }
+        
+        bool stopping;
+        {
+            QMutexLocker locker(&m_mutex);
+            stopping = m_stopping;
+        }
+        
+        if (step > 0 && !stopping) {
+            enqueueCompactionStep(promise, freed + step);
+            return;
+        }
+        
+        if (!stopping) {
+            if (freed > 0) {
+                database.checkpointWal();
+            }
+            if (!database.refreshQueryStatistics()) {
+                qWarning() << "Statistiche ottimizzatore:" << database.lastError();
+            }
+        }
+        
+        promise->addResult(freed + qMax(step, 0));
+        promise->finish();
+    });
+}
+
+void AsyncDatabase::workerLoop()
+{
+    // La connessione nasce e muore in questo thread
+    Database database(m_connectionName);
+    if (!database.initialize(m_databasePath)) {
+        qWarning() << "Thread database: inizializzazione fallita:" << database.lastError();
+        emit requestFailed(database.lastError());
+    }
+    
+    forever {
+        Request request;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_queue.empty() && !m_stopping) {
+                m_condition.wait(&m_mutex);
+            }
+            
+            if (m_queue.empty()) {
+                break; // Arresto richiesto e coda vuota
+            }
+            
+            request = m_queue.top();
+            m_queue.pop();
+        }
+        
+        request.task(database);
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef ASYNCDATABASE_H
+#define ASYNCDATABASE_H
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QList>
+#include <QtCore/QFuture>
+#include <QtCore/QPromise>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QThread>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "database.h"
+#include "databasereadpool.h"
+
+// Facciata asincrona del database: le scritture vengono accodate a un thread
+// dedicato che possiede la propria connessione QSqlDatabase, le letture vanno
+// al pool di connessioni in sola lettura; i risultati tornano tramite QFuture.
+// La GUI non resta mai bloccata su SQLite.
+class AsyncDatabase : public QObject
+{
+    Q_OBJECT
+
+public:
+    // A parità di priorità le richieste vengono eseguite in ordine di arrivo
+    enum Priority {
+        BackgroundPriority = 0,     // esportazioni, importazioni, manutenzione
+        NormalPriority = 1,         // caricamenti e ricerche
+        InteractivePriority = 2     // inserimento QSO durante il logging
+    };
+    
+    explicit AsyncDatabase(const QString &databasePath, QObject *parent = nullptr);
+    ~AsyncDatabase();
+    
+    // Contact operations
+    QFuture<Contact> addContact(const Contact &contact, Priority priority = InteractivePriority);
+    QFuture<int> addContacts(const QList<Contact> &contacts, const QString &importSource = QString(),
+                             Priority priority = BackgroundPriority);
+    QFuture<bool> updateContact(const Contact &contact, Priority priority = InteractivePriority);
+    QFuture<bool> deleteContact(int contactId, Priority priority = InteractivePriority);
+    QFuture<bool> deleteContacts(const QList<int> &contactIds, Priority priority = NormalPriority);
+    QFuture<bool> updateField(const QList<int> &contactIds, Database::ContactField field, const QString &value,
+                              Priority priority = NormalPriority);
+    QFuture<bool> deleteImportBatch(qint64 importBatch, Priority priority = NormalPriority);
+    QFuture<Contact> getContact(int contactId, Priority priority = NormalPriority);
+    QFuture<QList<Contact>> getAllContacts(Priority priority = NormalPriority);
+    QFuture<QList<CompactContact>> getAllCompactContacts(Priority priority = NormalPriority);
+    QFuture<QList<Contact>> searchContacts(const QString &searchTerm, Priority priority = NormalPriority);
+    
+    // Maintenance: converte a lotti le date ancora senza epoch intero,
+    // restituisce il numero totale di righe convertite
+    QFuture<int> backfillEpochs();
+    // Compattazione incrementale a passi di Database::VacuumPagesPerStep,
+    // poi checkpoint e aggiornamento delle statistiche dell'ottimizzatore;
+    // restituisce le pagine restituite al file system
+    QFuture<int> compactDatabase();
+    // Sposta negli archivi annuali i QSO precedenti a cutoffYear
+    QFuture<int> archiveContactsBefore(int cutoffYear, Priority priority = BackgroundPriority);
+    // Dati dell'operatore e ricalcolo delle distanze in una transazione
+    QFuture<bool> setOperatorData(const Database::OperatorData &data, Priority priority = NormalPriority);
+    
+    // Esegue una funzione qualsiasi sulla connessione del thread database
+    template <typename Result>
+    QFuture<Result> run(Priority priority, std::function<Result(Database &)> task);
+    
+    // Esegue una lettura su una connessione in sola lettura del pool
+    template <typename Result>
+    QFuture<Result> read(Priority priority, std::function<Result(Database &)> task);
+    
+    int pendingRequests() const;
+    DatabaseReadPool::Metrics readPoolMetrics() const;
+
+signals:
+    void requestFailed(const QString &error);
+
+private:
+    struct Request {
+        int priority;
+        quint64 sequence;
+        std::function<void(Database &)> task;
+    };
+    
+    struct RequestOrder {
+        bool operator()(const Request &a, const Request &b) const
+        {
+            // priority_queue estrae il massimo: prima la priorità più alta,
+            // poi la richiesta più vecchia
+            if (a.priority != b.priority) {
+                return a.priority < b.priority;
+            }
+            return a.sequence > b.sequence;
+        }
+    };
+    
+    void enqueue(Priority priority, std::function<void(Database &)> task);
+    void enqueueBackfillBatch(std::shared_ptr<QPromise<int>> promise, int converted);
+    void enqueueCompactionStep(std::shared_ptr<QPromise<int>> promise, int freed);
+    void workerLoop();
+    
+    QString m_databasePath;
+    QString m_connectionName;
+    QThread *m_thread;
+    std::unique_ptr<DatabaseReadPool> m_readPool;
+    
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    std::priority_queue<Request, std::vector<Request>, RequestOrder> m_queue;
+    quint64 m_nextSequence = 0;
+    bool m_stopping = false;
+};
+
+template <typename Result>
+QFuture<Result> AsyncDatabase::run(Priority priority, std::function<Result(Database &)> task)
+{
+    // QPromise non è copiabile: la std::function accodata ne condivide il possesso
+    auto promise = std::make_shared<QPromise<Result>>();
+    QFuture<Result> future = promise->future();
+    promise->start();
+    
+    enqueue(priority, [promise, task](Database &database) {
+        promise->addResult(task(database));
+        promise->finish();
+    });
+    
+    return future;
+}
+
+template <typename Result>
+QFuture<Result> AsyncDatabase::read(Priority priority, std::function<Result(Database &)> task)
+{
+    return m_readPool->run<Result>(std::move(task), int(priority));
+}
+
+#endif // ASYNCDATABASE_H
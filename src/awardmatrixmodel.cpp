@@ -0,0 +1,70 @@
+#include "awardmatrixmodel.h"
+
+AwardMatrixModel::AwardMatrixModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+void AwardMatrixModel::setMatrix(const QList<AwardTracker::MatrixRow> &rows, const QStringList &bands)
+{
+    beginResetModel();
+    m_rows = rows;
+    // Oltre MaxMatrixBands la maschera non ha bit: quelle bande non hanno colonna
+    m_bands = bands.mid(0, AwardTracker::MaxMatrixBands);
+    endResetModel();
+}
+
+int AwardMatrixModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int AwardMatrixModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnFirstBand + m_bands.size();
+}
+
+QVariant AwardMatrixModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+    
+    const AwardTracker::MatrixRow &row = m_rows.at(index.row());
+    const int column = index.column();
+    
+    if (column >= ColumnFirstBand) {
+        const int band = column - ColumnFirstBand;
+        const bool worked = row.bandMask & (quint64(1) << band);
+        switch (role) {
+        case Qt::DisplayRole:
+            return worked ? "X" : QString();
+        case Qt::AccessibleTextRole:
+            return QString("%1 %2: %3").arg(row.entity, m_bands.at(band), worked ? "lavorato" : "non lavorato");
+        case Qt::TextAlignmentRole:
+            return Qt::AlignCenter;
+        }
+        return QVariant();
+    }
+    
+    if (role == Qt::DisplayRole) {
+        return column == ColumnEntity ? QVariant(row.entity) : QVariant(row.qsoCount);
+    }
+    return QVariant();
+}
+
+QVariant AwardMatrixModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    
+    switch (section) {
+    case ColumnEntity:
+        return "Entità";
+    case ColumnQsoCount:
+        return "QSO";
+    default:
+        return m_bands.value(section - ColumnFirstBand);
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef AWARDMATRIXMODEL_H
+#define AWARDMATRIXMODEL_H
+
+#include <QtCore/QAbstractTableModel>
+#include <QtCore/QList>
+#include <QtCore/QStringList>
+#include "awardtracker.h"
+
+// Matrice di un diploma (entità per banda) letta dalle maschere di bit di
+// AwardTracker: la vista chiede solo le celle visibili, anche con decine di
+// migliaia di entità non si creano oggetti per cella.
+class AwardMatrixModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        ColumnEntity = 0,
+        ColumnQsoCount,
+        ColumnFirstBand     // una colonna per banda, nell'ordine di AwardTracker::bands()
+    };
+    
+    explicit AwardMatrixModel(QObject *parent = nullptr);
+    
+    void setMatrix(const QList<AwardTracker::MatrixRow> &rows, const QStringList &bands);
+    
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    QList<AwardTracker::MatrixRow> m_rows;
+    QStringList m_bands;
+};
+
+#endif // AWARDMATRIXMODEL_H
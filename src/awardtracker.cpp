@@ -0,0 +1,191 @@
+#include "awardtracker.h"
+#include "maidenhead.h"
+#include <algorithm>
+
+AwardTracker::AwardTracker()
+{
+}
+
+QString AwardTracker::awardName(Award award)
+{
+    switch (award) {
+    case DxccAward:
+        return "DXCC";
+    case GridAward:
+        return "Quadrati locatore (VUCC)";
+    default:
+        return QString();
+    }
+}
+
+QString AwardTracker::entityFor(Award award, const Contact &contact)
+{
+    return entityFor(award, contact.dxcc(), contact.locator());
+}
+
+QString AwardTracker::entityFor(Award award, const QString &dxcc, const QString &locator)
+{
+    if (award == DxccAward) {
+        return dxcc.trimmed().toUpper();
+    }
+    
+    const QString grid = locator.trimmed().toUpper().left(4);
+    return grid.size() == 4 && Maidenhead::isValid(grid) ? grid : QString();
+}
+
+void AwardTracker::load(const QList<Database::AwardSummary> &summaries)
+{
+    clear();
+    for (const Database::AwardSummary &summary : summaries) {
+        apply(summary.dxcc, summary.grid, summary.band, summary.mode, summary.count);
+    }
+}
+
+void AwardTracker::add(const Contact &contact)
+{
+    apply(contact.dxcc(), contact.locator(), contact.band(), contact.mode(), 1);
+}
+
+void AwardTracker::remove(const Contact &contact)
+{
+    apply(contact.dxcc(), contact.locator(), contact.band(), contact.mode(), -1);
+}
+
+void AwardTracker::clear()
+{
+    for (AwardState &state : m_awards) {
+        state = AwardState();
+    }
+    m_bandIndex.clear();
+    m_bands.clear();
+    m_modeIndex.clear();
+}
+
+int AwardTracker::bandIndex(const QString &band)
+{
+    const auto it = m_bandIndex.constFind(band);
+    if (it != m_bandIndex.constEnd()) {
+        return it.value();
+    }
+    
+    m_bands.append(band);
+    return *m_bandIndex.insert(band, m_bands.size() - 1);
+}
+
+int AwardTracker::modeIndex(const QString &mode)
+{
+    const auto it = m_modeIndex.constFind(mode);
+    if (it != m_modeIndex.constEnd()) {
+        return it.value();
+    }
+    
+    return *m_modeIndex.insert(mode, m_modeIndex.size());
+}
+
+int AwardTracker::applyCount(QHash<quint64, int> &counts, quint64 key, int delta)
+{
+    auto it = counts.find(key);
+    const int value = (it != counts.end() ? it.value() : 0) + delta;
+    
+    if (value <= 0) {
+        if (it != counts.end()) {
+            counts.erase(it);
+        }
+        return 0;
+    }
+    
+    if (it != counts.end()) {
+        it.value() = value;
+    } else {
+        counts.insert(key, value);
+    }
+    return value;
+}
+
+void AwardTracker::apply(const QString &dxcc, const QString &locator, const QString &band, const QString &mode, int delta)
+{
+    const int bandId = bandIndex(band);
+    const int modeId = modeIndex(mode);
+    
+    for (int award = 0; award < AwardCount; ++award) {
+        const QString entity = entityFor(Award(award), dxcc, locator);
+        if (entity.isEmpty()) {
+            continue;
+        }
+        
+        AwardState &state = m_awards[award];
+        int index = state.entityIndex.value(entity, -1);
+        if (index < 0) {
+            if (delta < 0) {
+                continue;   // mai contato: niente da togliere
+            }
+            index = state.entities.size();
+            state.entityIndex.insert(entity, index);
+            state.entities.append(entity);
+            state.entityCounts.append(0);
+            state.bandMasks.append(0);
+        }
+        
+        // Chiavi: entità nei 32 bit alti, poi banda e modo a 16 bit
+        const quint64 entityKey = quint64(index) << 32;
+        const int previous = state.entityCounts.at(index);
+        const int current = qMax(previous + delta, 0);
+        state.entityCounts[index] = current;
+        if (previous == 0 && current > 0) {
+            state.workedEntities++;
+        } else if (previous > 0 && current == 0) {
+            state.workedEntities--;
+        }
+        
+        const int bandCount = applyCount(state.bandCounts, entityKey | quint64(bandId), delta);
+        if (bandId < MaxMatrixBands) {
+            const quint64 bit = quint64(1) << bandId;
+            state.bandMasks[index] = bandCount > 0 ? state.bandMasks.at(index) | bit : state.bandMasks.at(index) & ~bit;
+        }
+        applyCount(state.modeCounts, entityKey | quint64(modeId), delta);
+        applyCount(state.slotCounts, entityKey | (quint64(bandId) << 16) | quint64(modeId), delta);
+    }
+}
+
+AwardTracker::Novelty AwardTracker::novelty(Award award, const QString &entity, const QString &band,
+                                            const QString &mode) const
+{
+    const AwardState &state = m_awards[award];
+    const int index = state.entityIndex.value(entity, -1);
+    if (index < 0 || state.entityCounts.at(index) == 0) {
+        return NewEntity;
+    }
+    
+    // Banda o modo mai visti: nessun contatore con quella chiave
+    const quint64 entityKey = quint64(index) << 32;
+    const int bandId = m_bandIndex.value(band, -1);
+    const int modeId = m_modeIndex.value(mode, -1);
+    if (bandId < 0 || !state.bandCounts.contains(entityKey | quint64(bandId))) {
+        return NewBand;
+    }
+    if (modeId < 0 || !state.modeCounts.contains(entityKey | quint64(modeId))) {
+        return NewMode;
+    }
+    if (!state.slotCounts.contains(entityKey | (quint64(bandId) << 16) | quint64(modeId))) {
+        return NewSlot;
+    }
+    return NotNew;
+}
+
+QList<AwardTracker::MatrixRow> AwardTracker::matrix(Award award) const
+{
+    const AwardState &state = m_awards[award];
+    QList<MatrixRow> rows;
+    rows.reserve(state.workedEntities);
+    
+    for (int index = 0; index < state.entities.size(); ++index) {
+        if (state.entityCounts.at(index) > 0) {
+            rows.append(MatrixRow{state.entities.at(index), state.entityCounts.at(index), state.bandMasks.at(index)});
+        }
+    }
+    
+    std::sort(rows.begin(), rows.end(), [](const MatrixRow &a, const MatrixRow &b) {
+        return a.entity < b.entity;
+    });
+    return rows;
+}
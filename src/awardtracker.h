@@ -0,0 +1,88 @@
+#ifndef AWARDTRACKER_H
+#define AWARDTRACKER_H
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QList>
+#include <QtCore/QHash>
+
+#include "contact.h"
+#include "database.h"
+
+// Avanzamento dei diplomi in memoria: per ogni entità (paese DXCC, quadrato
+// del locatore) i contatori dei QSO per banda, per modo e per banda/modo, più
+// una maschera di bit delle bande lavorate per la matrice. Caricato dalla
+// query aggregata e aggiornato a ogni inserimento, modifica o cancellazione
+// (il vecchio contatto si sottrae, il nuovo si aggiunge): "è nuovo?" costa
+// qualche ricerca in tabella, la matrice si legge dalle maschere.
+class AwardTracker
+{
+public:
+    enum Award {
+        DxccAward = 0,
+        GridAward,          // quadrati di 4 caratteri (VUCC)
+        AwardCount
+    };
+    
+    // In ordine di rilevanza crescente
+    enum Novelty {
+        NotNew = 0,
+        NewSlot,            // combinazione banda/modo nuova per l'entità
+        NewMode,
+        NewBand,
+        NewEntity
+    };
+    
+    static constexpr int MaxMatrixBands = 64;   // bit della maschera per entità
+    
+    struct MatrixRow {
+        QString entity;
+        int qsoCount = 0;
+        quint64 bandMask = 0;   // bit i = bands().at(i) lavorata
+    };
+    
+    AwardTracker();
+    
+    void load(const QList<Database::AwardSummary> &summaries);
+    void add(const Contact &contact);
+    void remove(const Contact &contact);
+    void clear();
+    
+    Novelty novelty(Award award, const QString &entity, const QString &band, const QString &mode) const;
+    int workedCount(Award award) const { return m_awards[award].workedEntities; }
+    
+    // Colonne della matrice, nell'ordine dei bit
+    QStringList bands() const { return m_bands; }
+    // Entità lavorate in ordine alfabetico
+    QList<MatrixRow> matrix(Award award) const;
+    
+    static QString awardName(Award award);
+    // Entità del contatto per il diploma; vuota se il campo manca o non è valido
+    static QString entityFor(Award award, const Contact &contact);
+    static QString entityFor(Award award, const QString &dxcc, const QString &locator);
+
+private:
+    struct AwardState {
+        QHash<QString, int> entityIndex;
+        QStringList entities;
+        QList<int> entityCounts;
+        QList<quint64> bandMasks;
+        QHash<quint64, int> bandCounts;     // (entità, banda)
+        QHash<quint64, int> modeCounts;     // (entità, modo)
+        QHash<quint64, int> slotCounts;     // (entità, banda, modo)
+        int workedEntities = 0;
+    };
+    
+    void apply(const QString &dxcc, const QString &locator, const QString &band, const QString &mode, int delta);
+    int bandIndex(const QString &band);
+    int modeIndex(const QString &mode);
+    // Nuovo valore del contatore; a zero la voce viene tolta
+    static int applyCount(QHash<quint64, int> &counts, quint64 key, int delta);
+    
+    AwardState m_awards[AwardCount];
+    QHash<QString, int> m_bandIndex;
+    QStringList m_bands;
+    QHash<QString, int> m_modeIndex;
+};
+
+#endif // AWARDTRACKER_H
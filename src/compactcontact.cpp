@@ -0,0 +1,167 @@
+#include "compactcontact.h"
+#include <QtCore/QByteArray>
+#include <cstring>
+
+StringInterner::StringInterner()
+{
+    // Id 0 = stringa vuota
+    m_values.append(QString());
+    m_ids.insert(QString(), 0);
+}
+
+StringInterner &StringInterner::instance()
+{
+    static StringInterner interner;
+    return interner;
+}
+
+quint32 StringInterner::intern(const QString &value)
+{
+    if (value.isEmpty()) {
+        return 0;
+    }
+    
+    {
+        QReadLocker locker(&m_lock);
+        const auto it = m_ids.constFind(value);
+        if (it != m_ids.constEnd()) {
+            return it.value();
+        }
+    }
+    
+    QWriteLocker locker(&m_lock);
+    // Un altro thread può averla inserita nel frattempo
+    const auto it = m_ids.constFind(value);
+    if (it != m_ids.constEnd()) {
+        return it.value();
+    }
+    
+    const quint32 id = quint32(m_values.size());
+    m_values.append(value);
+    m_ids.insert(value, id);
+    return id;
+}
+
+QString StringInterner::value(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    return m_values.value(int(id));
+}
+
+int StringInterner::size() const
+{
+    QReadLocker locker(&m_lock);
+    return m_values.size();
+}
+
+CompactContact::CompactContact(const Contact &contact)
+    : m_utcEpoch(contact.utcEpoch())
+    , m_id(contact.id())
+{
+    StringInterner &interner = StringInterner::instance();
+    m_bandId = interner.intern(contact.band());
+    m_modeId = interner.intern(contact.mode());
+    m_operatorId = interner.intern(contact.operatorCall());
+    m_dxccId = interner.intern(contact.dxcc());
+    
+    packText(m_callsign, sizeof(m_callsign), contact.callsign(), CallsignOverflow);
+    packText(m_rstSent, sizeof(m_rstSent), contact.rstSent(), RstSentOverflow);
+    packText(m_rstReceived, sizeof(m_rstReceived), contact.rstReceived(), RstReceivedOverflow);
+    packText(m_locator, sizeof(m_locator), contact.locator(), LocatorOverflow);
+}
+
+Contact CompactContact::toContact() const
+{
+    Contact contact;
+    contact.setId(m_id);
+    contact.setUtcEpoch(m_utcEpoch);
+    contact.setCallsign(callsign());
+    contact.setBand(band());
+    contact.setMode(mode());
+    contact.setRstSent(rstSent());
+    contact.setRstReceived(rstReceived());
+    contact.setDxcc(dxcc());
+    contact.setLocator(locator());
+    contact.setOperatorCall(operatorCall());
+    return contact;
+}
+
+QString CompactContact::callsign() const
+{
+    return unpackText(m_callsign, sizeof(m_callsign), CallsignOverflow);
+}
+
+QString CompactContact::band() const
+{
+    return StringInterner::instance().value(m_bandId);
+}
+
+QString CompactContact::mode() const
+{
+    return StringInterner::instance().value(m_modeId);
+}
+
+QString CompactContact::rstSent() const
+{
+    return unpackText(m_rstSent, sizeof(m_rstSent), RstSentOverflow);
+}
+
+QString CompactContact::rstReceived() const
+{
+    return unpackText(m_rstReceived, sizeof(m_rstReceived), RstReceivedOverflow);
+}
+
+QString CompactContact::dxcc() const
+{
+    return StringInterner::instance().value(m_dxccId);
+}
+
+QString CompactContact::locator() const
+{
+    return unpackText(m_locator, sizeof(m_locator), LocatorOverflow);
+}
+
+QString CompactContact::operatorCall() const
+{
+    return StringInterner::instance().value(m_operatorId);
+}
+
+bool CompactContact::hasSameCallsign(const CompactContact &other) const
+{
+    const bool overflow = m_overflow & CallsignOverflow;
+    const bool otherOverflow = other.m_overflow & CallsignOverflow;
+    
+    // Un valore inline e uno internato non possono coincidere; con la stessa
+    // rappresentazione basta confrontare i byte (l'internamento è univoco)
+    return overflow == otherOverflow
+        && std::memcmp(m_callsign, other.m_callsign, sizeof(m_callsign)) == 0;
+}
+
+void CompactContact::packText(char *buffer, int size, const QString &value, OverflowFlag flag)
+{
+    bool fits = value.size() <= size;
+    for (int i = 0; fits && i < value.size(); ++i) {
+        fits = value.at(i).unicode() < 0x80;
+    }
+    
+    std::memset(buffer, 0, size_t(size));
+    if (fits) {
+        for (int i = 0; i < value.size(); ++i) {
+            buffer[i] = char(value.at(i).unicode());
+        }
+    } else {
+        const quint32 id = StringInterner::instance().intern(value);
+        std::memcpy(buffer, &id, sizeof(id));
+        m_overflow |= flag;
+    }
+}
+
+QString CompactContact::unpackText(const char *buffer, int size, OverflowFlag flag) const
+{
+    if (m_overflow & flag) {
+        quint32 id;
+        std::memcpy(&id, buffer, sizeof(id));
+        return StringInterner::instance().value(id);
+    }
+    return QString::fromLatin1(buffer, qsizetype(qstrnlen(buffer, size_t(size))));
+}
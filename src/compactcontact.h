@@ -0,0 +1,94 @@
+#ifndef COMPACTCONTACT_H
+#define COMPACTCONTACT_H
+
+#include <QtCore/QString>
+#include <QtCore/QList>
+#include <QtCore/QHash>
+#include <QtCore/QReadWriteLock>
+
+#include "contact.h"
+
+// Tabella di internamento condivisa: ogni stringa distinta (banda, modo,
+// operatore, DXCC...) è memorizzata una sola volta e indicata da un id.
+// L'id 0 è riservato alla stringa vuota.
+class StringInterner
+{
+public:
+    static StringInterner &instance();
+    
+    quint32 intern(const QString &value);
+    QString value(quint32 id) const;
+    int size() const;
+
+private:
+    StringInterner();
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+    
+    mutable QReadWriteLock m_lock;
+    QHash<QString, quint32> m_ids;
+    QList<QString> m_values;
+};
+
+// Rappresentazione compatta in memoria di un QSO (64 byte, nessuna
+// allocazione per record): id internati per banda, modo, operatore e DXCC,
+// epoch UTC a 64 bit e buffer fissi per nominativo, RST e locatore.
+// Espone gli stessi getter di Contact; toContact() riporta all'API completa.
+class CompactContact
+{
+public:
+    CompactContact() = default;
+    explicit CompactContact(const Contact &contact);
+    
+    Contact toContact() const;
+    
+    // Getters (stessa interfaccia di Contact)
+    int id() const { return m_id; }
+    qint64 utcEpoch() const { return m_utcEpoch; }
+    bool hasDateTime() const { return m_utcEpoch != Contact::InvalidEpoch; }
+    QString callsign() const;
+    QString band() const;
+    QString mode() const;
+    QString rstSent() const;
+    QString rstReceived() const;
+    QString dxcc() const;
+    QString locator() const;
+    QString operatorCall() const;
+    
+    // Id internati: confronti e raggruppamenti senza stringhe
+    quint32 bandId() const { return m_bandId; }
+    quint32 modeId() const { return m_modeId; }
+    quint32 operatorId() const { return m_operatorId; }
+    quint32 dxccId() const { return m_dxccId; }
+    
+    bool hasSameCallsign(const CompactContact &other) const;
+
+private:
+    // Valori che non entrano nel buffer fisso (troppo lunghi o non ASCII)
+    // vengono internati e il buffer contiene l'id
+    enum OverflowFlag : quint8 {
+        CallsignOverflow = 0x01,
+        RstSentOverflow = 0x02,
+        RstReceivedOverflow = 0x04,
+        LocatorOverflow = 0x08
+    };
+    
+    void packText(char *buffer, int size, const QString &value, OverflowFlag flag);
+    QString unpackText(const char *buffer, int size, OverflowFlag flag) const;
+    
+    qint64 m_utcEpoch = Contact::InvalidEpoch;
+    qint32 m_id = -1;
+    quint32 m_bandId = 0;
+    quint32 m_modeId = 0;
+    quint32 m_operatorId = 0;
+    quint32 m_dxccId = 0;
+    char m_callsign[16] = {};
+    char m_rstSent[4] = {};
+    char m_rstReceived[4] = {};
+    char m_locator[8] = {};
+    quint8 m_overflow = 0;
+};
+
+Q_DECLARE_TYPEINFO(CompactContact, Q_RELOCATABLE_TYPE);
+
+#endif // COMPACTCONTACT_H
@@ -4,14 +4,14 @@
 
 Contact::Contact()
     : m_id(-1)
-    , m_dateTime(QDateTime::currentDateTimeUtc())
+    , m_utcEpoch(QDateTime::currentSecsSinceEpoch())
 {
 }
 
 Contact::Contact(const QString &callsign, const QString &band, const QString &mode,
                  const QString &rstSent, const QString &rstReceived, const QString &operatorCall)
     : m_id(-1)
-    , m_dateTime(QDateTime::currentDateTimeUtc())
+    , m_utcEpoch(QDateTime::currentSecsSinceEpoch())
     , m_callsign(callsign.toUpper())
     , m_band(band)
     , m_mode(mode)
@@ -21,6 +21,19 @@ Contact::Contact(const QString &callsign, const QString &band, const QString &mo
 {
 }
 
+QDateTime Contact::dateTime() const
+{
+    if (m_utcEpoch == InvalidEpoch) {
+        return QDateTime();
+    }
+    return QDateTime::fromSecsSinceEpoch(m_utcEpoch, QTimeZone::utc());
+}
+
+void Contact::setDateTime(const QDateTime &dateTime)
+{
+    m_utcEpoch = dateTime.isValid() ? dateTime.toSecsSinceEpoch() : InvalidEpoch;
+}
+
 bool Contact::isValid() const
 {
     // Validazione nominativo (8-10 caratteri alfanumerici)
@@ -141,7 +154,7 @@ QJsonObject Contact::toJson() const
 {
     QJsonObject obj;
     obj["id"] = m_id;
-    obj["dateTime"] = m_dateTime.toString(Qt::ISODate);
+    obj["dateTime"] = dateTime().toString(Qt::ISODate);
     obj["callsign"] = m_callsign;
     obj["band"] = m_band;
     obj["mode"] = m_mode;
@@ -156,7 +169,7 @@ QJsonObject Contact::toJson() const
 void Contact::fromJson(const QJsonObject &json)
 {
     m_id = json["id"].toInt(-1);
-    m_dateTime = QDateTime::fromString(json["dateTime"].toString(), Qt::ISODate);
+    setDateTime(QDateTime::fromString(json["dateTime"].toString(), Qt::ISODate));
     m_callsign = json["callsign"].toString();
     m_band = json["band"].toString();
     m_mode = json["mode"].toString();
@@ -3,7 +3,9 @@
 
 #include <QtCore/QString>
 #include <QtCore/QDateTime>
+#include <QtCore/QTimeZone>
 #include <QtCore/QJsonObject>
+#include <limits>
 
 class Contact
 {
@@ -14,7 +16,9 @@ public:
 
     // Getters
     int id() const { return m_id; }
-    QDateTime dateTime() const { return m_dateTime; }
+    QDateTime dateTime() const;
+    qint64 utcEpoch() const { return m_utcEpoch; }
+    bool hasDateTime() const { return m_utcEpoch != InvalidEpoch; }
     QString callsign() const { return m_callsign; }
     QString band() const { return m_band; }
     QString mode() const { return m_mode; }
@@ -26,7 +30,8 @@ public:
 
     // Setters
     void setId(int id) { m_id = id; }
-    void setDateTime(const QDateTime &dateTime) { m_dateTime = dateTime; }
+    void setDateTime(const QDateTime &dateTime);
+    void setUtcEpoch(qint64 epoch) { m_utcEpoch = epoch; }
     void setCallsign(const QString &callsign) { m_callsign = callsign.toUpper(); }
     void setBand(const QString &band) { m_band = band; }
     void setMode(const QString &mode) { m_mode = mode; }
@@ -44,9 +49,12 @@ public:
     QJsonObject toJson() const;
     void fromJson(const QJsonObject &json);
 
+    // Data/ora non valida (es. ADIF senza QSO_DATE/TIME_ON leggibili)
+    static constexpr qint64 InvalidEpoch = std::numeric_limits<qint64>::min();
+
 private:
     int m_id;
-    QDateTime m_dateTime;
+    qint64 m_utcEpoch; // secondi UTC dall'epoch: niente fuso orario né QDateTime in memoria
     QString m_callsign;
     QString m_band;
     QString m_mode;
@@ -0,0 +1,184 @@
+#include "contactquery.h"
+#include "database.h"
+
+ContactQuery::ContactQuery()
+    : m_fromEpoch(Contact::InvalidEpoch)
+    , m_toEpoch(Contact::InvalidEpoch)
+    , m_sortOrder(Qt::DescendingOrder)
+    , m_limit(0)
+    , m_includeArchives(false)
+{
+}
+
+ContactQuery &ContactQuery::setTimeRange(const QDateTime &from, const QDateTime &to)
+{
+    return setEpochRange(from.isValid() ? from.toSecsSinceEpoch() : Contact::InvalidEpoch,
+                         to.isValid() ? to.toSecsSinceEpoch() : Contact::InvalidEpoch);
+}
+
+ContactQuery &ContactQuery::setEpochRange(qint64 fromEpoch, qint64 toEpoch)
+{
+    m_fromEpoch = fromEpoch;
+    m_toEpoch = toEpoch;
+    return *this;
+}
+
+ContactQuery &ContactQuery::setBands(const QStringList &bands)
+{
+    m_bands = bands;
+    return *this;
+}
+
+ContactQuery &ContactQuery::setModes(const QStringList &modes)
+{
+    m_modes = modes;
+    return *this;
+}
+
+ContactQuery &ContactQuery::setCallsignPrefix(const QString &prefix)
+{
+    // I nominativi sono salvati in maiuscolo (Contact::setCallsign)
+    m_callsignPrefix = prefix.trimmed().toUpper();
+    return *this;
+}
+
+ContactQuery &ContactQuery::setDxcc(const QString &dxcc)
+{
+    m_dxcc = dxcc;
+    return *this;
+}
+
+ContactQuery &ContactQuery::setSortOrder(Qt::SortOrder order)
+{
+    m_sortOrder = order;
+    return *this;
+}
+
+ContactQuery &ContactQuery::setLimit(int limit)
+{
+    m_limit = limit;
+    return *this;
+}
+
+ContactQuery &ContactQuery::setIncludeArchives(bool include)
+{
+    m_includeArchives = include;
+    return *this;
+}
+
+bool ContactQuery::isEmpty() const
+{
+    return m_fromEpoch == Contact::InvalidEpoch && m_toEpoch == Contact::InvalidEpoch
+        && m_bands.isEmpty() && m_modes.isEmpty()
+        && m_callsignPrefix.isEmpty() && m_dxcc.isEmpty();
+}
+
+QString ContactQuery::placeholders(int count)
+{
+    QStringList marks;
+    for (int i = 0; i < count; ++i) {
+        marks.append("?");
+    }
+    return marks.join(", ");
+}
+
+QString ContactQuery::toSql(QVariantList &bindValues, const QString &source) const
+{
+    QStringList conditions;
+    
+    // Ogni predicato corrisponde a un indice: idx_datetime_utc, idx_band,
+    // idx_mode, idx_callsign, idx_dxcc. SQLite sceglie il più selettivo.
+    // Bande e modi si filtrano sugli id interi dei dizionari
+    if (m_fromEpoch != Contact::InvalidEpoch) {
+        conditions.append("datetime_utc >= ?");
+        bindValues.append(m_fromEpoch);
+    }
+    
+    if (m_toEpoch != Contact::InvalidEpoch) {
+        conditions.append("datetime_utc < ?");
+        bindValues.append(m_toEpoch);
+    }
+    
+    if (!m_bands.isEmpty()) {
+        conditions.append(QString("band_id IN (SELECT id FROM dict_band WHERE name IN (%1))")
+            .arg(placeholders(m_bands.size())));
+        for (const QString &band : m_bands) {
+            bindValues.append(band);
+        }
+    }
+    
+    if (!m_modes.isEmpty()) {
+        conditions.append(QString("mode_id IN (SELECT id FROM dict_mode WHERE name IN (%1))")
+            .arg(placeholders(m_modes.size())));
+        for (const QString &mode : m_modes) {
+            bindValues.append(mode);
+        }
+    }
+    
+    if (!m_callsignPrefix.isEmpty()) {
+        // Prefisso come intervallo [prefisso, prefisso successivo): a differenza
+        // di LIKE 'ABC%' usa sempre l'indice, qualunque sia case_sensitive_like
+        QString upperBound = m_callsignPrefix;
+        upperBound[upperBound.size() - 1] = QChar(upperBound.back().unicode() + 1);
+        
+        conditions.append("callsign >= ? AND callsign < ?");
+        bindValues.append(m_callsignPrefix);
+        bindValues.append(upperBound);
+    }
+    
+    if (!m_dxcc.isEmpty()) {
+        conditions.append("dxcc = ?");
+        bindValues.append(m_dxcc);
+    }
+    
+    QString sql = "SELECT * FROM " + source;
+    if (!conditions.isEmpty()) {
+        sql += " WHERE " + conditions.join(" AND ");
+    }
+    
+    sql += m_sortOrder == Qt::AscendingOrder ? " ORDER BY datetime_utc ASC" : " ORDER BY datetime_utc DESC";
+    
+    if (m_limit > 0) {
+        sql += " LIMIT ?";
+        bindValues.append(m_limit);
+    }
+    
+    return sql;
+}
+
+ContactCursor::ContactCursor(const Database *database, QSqlQuery query, bool valid,
+                             const QStringList &archiveSchemas)
+    : m_database(database)
+    , m_query(query)
+    , m_valid(valid)
+    , m_position(-1)
+    , m_archiveSchemas(archiveSchemas)
+{
+}
+
+ContactCursor::~ContactCursor()
+{
+    close();
+}
+
+void ContactCursor::close()
+{
+    // DETACH fallisce finché l'istruzione che legge dagli archivi è attiva
+    m_query.finish();
+    if (!m_archiveSchemas.isEmpty()) {
+        m_database->detachSchemas(m_archiveSchemas);
+        m_archiveSchemas.clear();
+    }
+}
+
+bool ContactCursor::next()
+{
+    if (!m_valid || !m_query.next()) {
+        close();
+        return false;
+    }
+    
+    m_current = m_database->contactFromQuery(m_query);
+    m_position++;
+    return true;
+}
@@ -0,0 +1,97 @@
+#ifndef CONTACTQUERY_H
+#define CONTACTQUERY_H
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QDateTime>
+#include <QtCore/QVariant>
+#include <QtCore/QList>
+#include <QtSql/QSqlQuery>
+
+#include "contact.h"
+
+class Database;
+
+// Filtro sui contatti composto da predicati opzionali (intervallo di tempo,
+// bande, modi, prefisso nominativo, DXCC). Viene compilato in SQL con
+// parametri, usando solo confronti che SQLite risolve sugli indici:
+// uguaglianze/IN e intervalli, mai LIKE con jolly iniziale.
+//
+//     ContactQuery query;
+//     query.setTimeRange(inizio2024, inizio2025).setBands({"20m"}).setModes({"CW"});
+//     ContactCursor cursor = Database::instance()->openContactCursor(query);
+//     while (cursor.next()) { ... cursor.contact() ... }
+class ContactQuery
+{
+public:
+    ContactQuery();
+    
+    // Intervallo semiaperto [from, to); un estremo non valido non limita
+    ContactQuery &setTimeRange(const QDateTime &from, const QDateTime &to = QDateTime());
+    ContactQuery &setEpochRange(qint64 fromEpoch, qint64 toEpoch = Contact::InvalidEpoch);
+    ContactQuery &setBands(const QStringList &bands);
+    ContactQuery &setModes(const QStringList &modes);
+    ContactQuery &setCallsignPrefix(const QString &prefix);
+    ContactQuery &setDxcc(const QString &dxcc);
+    ContactQuery &setSortOrder(Qt::SortOrder order);
+    ContactQuery &setLimit(int limit);
+    // Collega tutti gli archivi annuali; con un intervallo di tempo vengono
+    // collegati comunque gli anni archiviati che vi ricadono
+    ContactQuery &setIncludeArchives(bool include);
+    
+    bool isEmpty() const;
+    qint64 fromEpoch() const { return m_fromEpoch; }
+    qint64 toEpoch() const { return m_toEpoch; }
+    bool includeArchives() const { return m_includeArchives; }
+    
+    // SQL parametrizzato: i valori da associare vengono aggiunti a bindValues
+    // nello stesso ordine dei segnaposto. source è la tabella (o la sottoquery
+    // di unione con gli archivi) da cui leggere
+    QString toSql(QVariantList &bindValues, const QString &source = QString("contacts")) const;
+
+private:
+    static QString placeholders(int count);
+    
+    qint64 m_fromEpoch;
+    qint64 m_toEpoch;
+    QStringList m_bands;
+    QStringList m_modes;
+    QString m_callsignPrefix;
+    QString m_dxcc;
+    Qt::SortOrder m_sortOrder;
+    int m_limit;
+    bool m_includeArchives;
+};
+
+// Cursore in avanti sui risultati di una ContactQuery: le righe vengono
+// decodificate una alla volta, senza caricare l'intero risultato in memoria.
+// Va usato nel thread della connessione che l'ha aperto. Gli archivi
+// collegati per la query vengono scollegati a fine risultati o alla
+// distruzione del cursore, che per questo non si copia.
+class ContactCursor
+{
+public:
+    ~ContactCursor();
+    
+    bool isValid() const { return m_valid; }
+    bool next();
+    Contact contact() const { return m_current; }
+    int position() const { return m_position; }
+
+private:
+    friend class Database;
+    
+    ContactCursor(const Database *database, QSqlQuery query, bool valid, const QStringList &archiveSchemas);
+    Q_DISABLE_COPY_MOVE(ContactCursor)
+    
+    void close();
+    
+    const Database *m_database;
+    QSqlQuery m_query;
+    bool m_valid;
+    int m_position;
+    Contact m_current;
+    QStringList m_archiveSchemas;   // archivi collegati per questa query
+};
+
+#endif // CONTACTQUERY_H
@@ -1,298 +1,2484 @@
 #include "database.h"
+#include "databasebackup.h"
+#include "queryprofiler.h"
+#include "maidenhead.h"
 #include <QtSql/QSqlQuery>
 #include <QtSql/QSqlError>
 #include <QtCore/QStandardPaths>
 #include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QUrl>
+#include <QtCore/QTimeZone>
+#include <QtCore/QSettings>
 #include <QtCore/QDebug>
 #include <QScopedPointer>
+#include <QtCore/QHash>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QElapsedTimer>
+#include <algorithm>
+#include <limits>
 
 Database* Database::m_instance = nullptr;
+QHash<QString, Database*> Database::m_logbooks;
+QHash<QString, Database::SettingsCache> Database::m_settingsCaches;
+QMutex Database::m_settingsMutex;
+QHash<QString, Database::DictionarySet> Database::m_dictionaryCaches;
+QMutex Database::m_dictionaryMutex;
 
-Database::Database()
+Database::Database(const QString &connectionName)
 {
-    m_db = QSqlDatabase::addDatabase("QSQLITE");
+    // Connessione predefinita per il thread GUI, connessioni con nome
+    // per gli altri thread (una QSqlDatabase non si condivide tra thread)
+    if (connectionName.isEmpty()) {
+        m_db = QSqlDatabase::addDatabase("QSQLITE");
+    } else {
+        m_db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    }
 }
 
 Database::~Database()
 {
     close();
+    
+    const QString connectionName = m_db.connectionName();
+    if (connectionName != QLatin1String(QSqlDatabase::defaultConnection)) {
+        m_db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(connectionName);
+    }
 }
 
 Database* Database::instance()
 {
     if (!m_instance) {
         m_instance = new Database();
+        notifier(); // creato nel thread GUI
     }
     return m_instance;
 }
 
+DatabaseNotifier *Database::notifier()
+{
+    static DatabaseNotifier notifier;
+    return &notifier;
+}
+
 void Database::destroy()
 {
+    qDeleteAll(m_logbooks);
+    m_logbooks.clear();
+    
     if (m_instance) {
         delete m_instance;
         m_instance = nullptr;
     }
 }
 
-bool Database::initialize(const QString &dbPath)
+QString Database::defaultLogbookPath()
+{
+    QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataPath);
+    return dataPath + "/logbook.db";
+}
+
+QString Database::lastLogbookPath()
+{
+    // L'elenco dei logbook non può stare in un logbook: QSettings dell'applicazione
+    QSettings settings;
+    const QString path = settings.value("logbooks/current").toString();
+    return !path.isEmpty() && QFileInfo::exists(path) ? path : defaultLogbookPath();
+}
+
+QStringList Database::knownLogbooks()
+{
+    QSettings settings;
+    QStringList logbooks;
+    
+    const QStringList recent = settings.value("logbooks/recent").toStringList();
+    for (const QString &path : recent) {
+        if (QFileInfo::exists(path)) {
+            logbooks.append(path);
+        }
+    }
+    
+    return logbooks;
+}
+
+QString Database::logbookName(const QString &path)
+{
+    return QFileInfo(path).completeBaseName();
+}
+
+void Database::rememberLogbook(const QString &path)
+{
+    QSettings settings;
+    QStringList recent = settings.value("logbooks/recent").toStringList();
+    recent.removeAll(path);
+    recent.prepend(path);
+    while (recent.size() > MaxRecentLogbooks) {
+        recent.removeLast();
+    }
+    
+    settings.setValue("logbooks/recent", recent);
+    settings.setValue("logbooks/current", path);
+}
+
+Database *Database::openLogbook(const QString &path, QString *errorMessage)
+{
+    const QString key = QFileInfo(path).absoluteFilePath();
+    Database *active = instance();
+    
+    // Primo logbook della sessione: usa la connessione predefinita
+    if (!active->isOpen()) {
+        if (!active->initialize(key)) {
+            if (errorMessage) {
+                *errorMessage = active->lastError();
+            }
+            return nullptr;
+        }
+        return active;
+    }
+    
+    if (active->m_cacheKey == key) {
+        return active;
+    }
+    
+    if (Database *cached = m_logbooks.value(key)) {
+        return cached;
+    }
+    
+    // Connessione con nome nel thread GUI, tenuta aperta fino a closeLogbook()
+    Database *database = new Database(QString("qtlogbook_logbook_%1").arg(qHash(key), 0, 16));
+    if (!database->initialize(key)) {
+        if (errorMessage) {
+            *errorMessage = database->lastError();
+        }
+        delete database;
+        return nullptr;
+    }
+    
+    m_logbooks.insert(key, database);
+    return database;
+}
+
+bool Database::switchLogbook(const QString &path, QString *errorMessage)
 {
-    QString path = dbPath;
-    if (path.isEmpty()) {
-        QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-        QDir().mkpath(dataPath);
-        path = dataPath + "/logbook.db";
+    Database *database = openLogbook(path, errorMessage);
+    if (!database) {
+        return false;
+    }
+    
+    // Il logbook attivo resta aperto in cache per un ritorno immediato
+    if (database != m_instance) {
+        m_logbooks.remove(database->m_cacheKey);
+        m_logbooks.insert(m_instance->m_cacheKey, m_instance);
+        m_instance = database;
     }
     
+    rememberLogbook(database->m_cacheKey);
+    return true;
+}
+
+void Database::closeLogbook(const QString &path)
+{
+    // Il logbook attivo non si chiude: prima si passa a un altro
+    Database *database = m_logbooks.take(QFileInfo(path).absoluteFilePath());
+    delete database;
+}
+
+bool Database::initialize(const QString &dbPath)
+{
+    const QString path = dbPath.isEmpty() ? defaultLogbookPath() : dbPath;
+    
     m_db.setDatabaseName(path);
+    m_cacheKey = QFileInfo(path).absoluteFilePath();
+    // URI abilitati per collegare archivi e altri logbook con mode=ro
+    m_db.setConnectOptions("QSQLITE_OPEN_URI");
     
     if (!m_db.open()) {
         m_lastError = "Impossibile aprire il database: " + m_db.lastError().text();
         return false;
     }
     
+    // auto_vacuum va impostato prima di WAL: su un file nuovo il passaggio a
+    // WAL scrive l'intestazione e la modalità non si potrebbe più cambiare.
+    // Su un file esistente non ha effetto (vedi migrateSchema)
+    QSqlQuery pragma(m_db);
+    execQuery(pragma, "PRAGMA auto_vacuum = INCREMENTAL");
+    
+    // Più connessioni sullo stesso file (thread GUI e thread database):
+    // WAL permette letture durante le scritture, busy_timeout evita SQLITE_BUSY
+    execQuery(pragma, "PRAGMA journal_mode = WAL");
+    execQuery(pragma, "PRAGMA busy_timeout = 5000");
+    
     return createTables();
 }
 
+QString Database::databasePath() const
+{
+    return m_db.databaseName();
+}
+
+bool Database::restoreFromBackup(const QString &backupPath)
+{
+    const QString path = databasePath();
+    close();
+    
+    QString restoreError;
+    const bool restored = DatabaseBackup::restore(backupPath, path, &restoreError);
+    
+    // Le cache condivise descrivono il file precedente
+    {
+        QMutexLocker locker(&m_settingsMutex);
+        settingsCache() = SettingsCache();
+    }
+    invalidateDictionaryCache();
+    
+    // In caso di errore si riapre il database originale. Un backup di uno
+    // schema precedente viene migrato da initialize()
+    if (!initialize(path)) {
+        return false;
+    }
+    
+    if (!restored) {
+        m_lastError = restoreError;
+        return false;
+    }
+    
+    return true;
+}
+
+bool Database::initializeReadOnly(const QString &dbPath)
+{
+    // Connessione del pool di lettura: niente creazione tabelle né cambi di
+    // journal mode, il file è già stato preparato dalla connessione principale
+    m_db.setDatabaseName(dbPath);
+    m_cacheKey = QFileInfo(dbPath).absoluteFilePath();
+    m_db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_OPEN_URI;QSQLITE_BUSY_TIMEOUT=5000");
+    
+    if (!m_db.open()) {
+        m_lastError = "Impossibile aprire il database in sola lettura: " + m_db.lastError().text();
+        return false;
+    }
+    
+    QSqlQuery pragma(m_db);
+    execQuery(pragma, "PRAGMA query_only = 1");
+    
+    return true;
+}
+
 bool Database::isOpen() const
 {
     return m_db.isOpen();
 }
 
-void Database::close()
+void Database::close()
+{
+    if (m_db.isOpen()) {
+        m_db.close();
+    }
+}
+
+bool Database::createTables()
+{
+    if (!createContactsTable()) {
+        return false;
+    }
+    
+    if (!createSettingsTable()) {
+        return false;
+    }
+    
+    return migrateSchema();
+}
+
+int Database::schemaVersion() const
+{
+    QSqlQuery query(m_db);
+    execQuery(query, "PRAGMA user_version");
+    
+    if (query.next()) {
+        return query.value(0).toInt();
+    }
+    
+    return 0;
+}
+
+bool Database::migrateSchema()
+{
+    if (schemaVersion() >= SchemaVersion) {
+        return true;
+    }
+    
+    // Più connessioni possono inizializzare lo stesso file: BEGIN IMMEDIATE
+    // serializza le migrazioni e la versione viene ricontrollata sotto lock
+    QSqlQuery query(m_db);
+    if (!execQuery(query, "BEGIN IMMEDIATE")) {
+        m_lastError = "Errore avvio migrazione schema: " + query.lastError().text();
+        return false;
+    }
+    
+    const int version = schemaVersion();
+    
+    // Un passo per versione, tutti nella stessa transazione. Le statistiche
+    // (versione 2) dipendono dalla struttura di contacts: vengono create, o
+    // ricreate, dopo la normalizzazione della versione 3
+    if ((version < 1 && !migrateToEpochColumn())
+        || (version < 3 && !migrateToDictionaryTables())
+        || (version < 3 && !migrateToStatisticsTables())
+        || (version < 4 && !migrateToChangeJournal())
+        || (version < 5 && !migrateToImportBatches())
+        || (version < 7 && !migrateToGeoIndex())) {
+        execQuery(query, "ROLLBACK");
+        invalidateDictionaryCache();
+        return false;
+    }
+    
+    if (!execQuery(query, QString("PRAGMA user_version = %1").arg(qMax(version, int(SchemaVersion))))
+        || !execQuery(query, "COMMIT")) {
+        m_lastError = "Errore aggiornamento versione schema: " + query.lastError().text();
+        execQuery(query, "ROLLBACK");
+        invalidateDictionaryCache();
+        return false;
+    }
+    
+    // La normalizzazione libera molte pagine e l'auto_vacuum incrementale
+    // (versione 6) si attiva su un file esistente solo ricostruendolo: un
+    // solo VACUUM, fuori transazione, per entrambi
+    if (version < 6 && (version < 3 || autoVacuumMode() != IncrementalAutoVacuum)) {
+        execQuery(query, "PRAGMA auto_vacuum = INCREMENTAL");
+        if (!execQuery(query, "VACUUM")) {
+            qWarning() << "VACUUM dopo la migrazione non riuscito:" << query.lastError().text();
+        }
+    }
+    
+    return true;
+}
+
+bool Database::migrateToEpochColumn()
+{
+    // Versione 1: orario del QSO come epoch UTC intero accanto al testo ISO.
+    // Le righe esistenti restano NULL e vengono convertite a lotti da
+    // backfillEpochBatch() senza bloccare l'avvio
+    QSqlQuery query(m_db);
+    
+    bool hasColumn = false;
+    execQuery(query, "PRAGMA table_info(contacts)");
+    while (query.next()) {
+        if (query.value("name").toString() == "datetime_utc") {
+            hasColumn = true;
+        }
+    }
+    
+    if (!hasColumn && !execQuery(query, "ALTER TABLE contacts ADD COLUMN datetime_utc INTEGER")) {
+        m_lastError = "Errore aggiunta colonna datetime_utc: " + query.lastError().text();
+        return false;
+    }
+    
+    // Gli indici su datetime passano alla colonna intera
+    execQuery(query, "DROP INDEX IF EXISTS idx_dupe");
+    if (!execQuery(query, "CREATE INDEX IF NOT EXISTS idx_datetime_utc ON contacts(datetime_utc)")
+        || !execQuery(query, "CREATE INDEX IF NOT EXISTS idx_dupe_utc ON contacts(callsign, band, mode, datetime_utc)")) {
+        m_lastError = "Errore creazione indici datetime_utc: " + query.lastError().text();
+        return false;
+    }
+    
+    return true;
+}
+
+bool Database::migrateToDictionaryTables()
+{
+    // Versione 3: banda, modo e operatore in tabelle dizionario con chiavi
+    // intere. I dati passano in contacts_data; contacts diventa una vista con
+    // le stesse colonne di prima (più gli id), così le letture esistenti
+    // continuano a funzionare. Le scritture vanno direttamente su contacts_data
+    QSqlQuery query(m_db);
+    
+    const QStringList statements = {
+        "CREATE TABLE IF NOT EXISTS dict_band (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE)",
+        "CREATE TABLE IF NOT EXISTS dict_mode (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE)",
+        "CREATE TABLE IF NOT EXISTS dict_operator (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE)",
+        "INSERT OR IGNORE INTO dict_band (name) SELECT DISTINCT band FROM contacts",
+        "INSERT OR IGNORE INTO dict_mode (name) SELECT DISTINCT mode FROM contacts",
+        "INSERT OR IGNORE INTO dict_operator (name) SELECT DISTINCT operator_call FROM contacts",
+        R"(
+            CREATE TABLE contacts_data (
+                id INTEGER PRIMARY KEY AUTOINCREMENT,
+                datetime TEXT NOT NULL,
+                datetime_utc INTEGER,
+                callsign TEXT NOT NULL,
+                band_id INTEGER NOT NULL REFERENCES dict_band(id),
+                mode_id INTEGER NOT NULL REFERENCES dict_mode(id),
+                rst_sent TEXT NOT NULL,
+                rst_received TEXT NOT NULL,
+                dxcc TEXT,
+                locator TEXT,
+                operator_id INTEGER NOT NULL REFERENCES dict_operator(id),
+                created_at DATETIME DEFAULT CURRENT_TIMESTAMP
+            )
+        )",
+        R"(
+            INSERT INTO contacts_data
+            (id, datetime, datetime_utc, callsign, band_id, mode_id, rst_sent, rst_received,
+             dxcc, locator, operator_id, created_at)
+            SELECT c.id, c.datetime, c.datetime_utc, c.callsign, b.id, m.id, c.rst_sent, c.rst_received,
+                   c.dxcc, c.locator, o.id, c.created_at
+            FROM contacts c
+            JOIN dict_band b ON b.name = c.band
+            JOIN dict_mode m ON m.name = c.mode
+            JOIN dict_operator o ON o.name = c.operator_call
+        )",
+        // Gli id cancellati in coda non devono essere riassegnati
+        R"(
+            UPDATE sqlite_sequence
+            SET seq = MAX(seq, COALESCE((SELECT seq FROM sqlite_sequence WHERE name = 'contacts'), 0))
+            WHERE name = 'contacts_data'
+        )",
+        // Elimina anche indici e trigger della vecchia tabella
+        "DROP TABLE contacts",
+        R"(
+            CREATE VIEW contacts AS
+            SELECT c.id, c.datetime, c.datetime_utc, c.callsign,
+                   c.band_id, b.name AS band, c.mode_id, m.name AS mode,
+                   c.rst_sent, c.rst_received, c.dxcc, c.locator,
+                   c.operator_id, o.name AS operator_call, c.created_at
+            FROM contacts_data c
+            JOIN dict_band b ON b.id = c.band_id
+            JOIN dict_mode m ON m.id = c.mode_id
+            JOIN dict_operator o ON o.id = c.operator_id
+        )",
+        "CREATE INDEX idx_callsign ON contacts_data(callsign)",
+        "CREATE INDEX idx_datetime_utc ON contacts_data(datetime_utc)",
+        "CREATE INDEX idx_band ON contacts_data(band_id)",
+        "CREATE INDEX idx_mode ON contacts_data(mode_id)",
+        "CREATE INDEX idx_dxcc ON contacts_data(dxcc)",
+        "CREATE INDEX idx_dupe_utc ON contacts_data(callsign, band_id, mode_id, datetime_utc)"
+    };
+    
+    for (const QString &statement : statements) {
+        if (!execQuery(query, statement)) {
+            m_lastError = "Errore normalizzazione tabella contacts: " + query.lastError().text();
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool Database::migrateToChangeJournal()
+{
+    // Versione 4: registro persistente delle modifiche scritto da trigger.
+    // Vede le scritture di tutte le connessioni; AUTOINCREMENT garantisce
+    // numeri di sequenza mai riutilizzati anche dopo la potatura
+    QSqlQuery query(m_db);
+    
+    const QString updatedColumns = "datetime, callsign, band_id, mode_id, rst_sent, rst_received, dxcc, locator, operator_id";
+    const QStringList statements = {
+        R"(
+            CREATE TABLE IF NOT EXISTS change_journal (
+                seq INTEGER PRIMARY KEY AUTOINCREMENT,
+                contact_id INTEGER NOT NULL,
+                operation INTEGER NOT NULL
+            )
+        )",
+        QString("CREATE TRIGGER IF NOT EXISTS contacts_journal_insert AFTER INSERT ON contacts_data BEGIN "
+                "INSERT INTO change_journal (contact_id, operation) VALUES (NEW.id, %1); END").arg(ContactInserted),
+        // La sola conversione a epoch (datetime_utc) non cambia i dati visibili
+        QString("CREATE TRIGGER IF NOT EXISTS contacts_journal_update AFTER UPDATE OF %1 ON contacts_data BEGIN "
+                "INSERT INTO change_journal (contact_id, operation) VALUES (NEW.id, %2); END").arg(updatedColumns).arg(ContactUpdated),
+        QString("CREATE TRIGGER IF NOT EXISTS contacts_journal_delete AFTER DELETE ON contacts_data BEGIN "
+                "INSERT INTO change_journal (contact_id, operation) VALUES (OLD.id, %1); END").arg(ContactRemoved),
+        // Ogni 1000 voci elimina quelle oltre MaxChangeLogEntries: chi ha un
+        // watermark più vecchio del registro rimasto ricarica tutto
+        QString("CREATE TRIGGER IF NOT EXISTS change_journal_prune AFTER INSERT ON change_journal "
+                "WHEN NEW.seq % 1000 = 0 BEGIN "
+                "DELETE FROM change_journal WHERE seq <= NEW.seq - %1; END").arg(MaxChangeLogEntries)
+    };
+    
+    for (const QString &statement : statements) {
+        if (!execQuery(query, statement)) {
+            m_lastError = "Errore creazione registro modifiche: " + query.lastError().text();
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool Database::migrateToImportBatches()
+{
+    // Versione 5: ogni importazione è un lotto con id proprio, così si può
+    // annullare per intero ("elimina i QSO dell'importazione X")
+    QSqlQuery query(m_db);
+    
+    const QStringList statements = {
+        R"(
+            CREATE TABLE IF NOT EXISTS import_batches (
+                id INTEGER PRIMARY KEY AUTOINCREMENT,
+                source TEXT,
+                created_at DATETIME DEFAULT CURRENT_TIMESTAMP
+            )
+        )",
+        "ALTER TABLE contacts_data ADD COLUMN import_batch INTEGER REFERENCES import_batches(id)",
+        "CREATE INDEX IF NOT EXISTS idx_import_batch ON contacts_data(import_batch)",
+        "DROP VIEW contacts",
+        R"(
+            CREATE VIEW contacts AS
+            SELECT c.id, c.datetime, c.datetime_utc, c.callsign,
+                   c.band_id, b.name AS band, c.mode_id, m.name AS mode,
+                   c.rst_sent, c.rst_received, c.dxcc, c.locator,
+                   c.operator_id, o.name AS operator_call, c.import_batch, c.created_at
+            FROM contacts_data c
+            JOIN dict_band b ON b.id = c.band_id
+            JOIN dict_mode m ON m.id = c.mode_id
+            JOIN dict_operator o ON o.id = c.operator_id
+        )"
+    };
+    
+    for (const QString &statement : statements) {
+        if (!execQuery(query, statement)) {
+            m_lastError = "Errore creazione lotti di importazione: " + query.lastError().text();
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool Database::migrateToGeoIndex()
+{
+    // Versione 7: coordinate del locatore e distanza dall'operatore in
+    // contacts_data, R*Tree contacts_geo per le query per area. L'indice
+    // contiene punti (min = max) e segue le colonne tramite trigger
+    QSqlQuery query(m_db);
+    
+    const QStringList statements = {
+        "ALTER TABLE contacts_data ADD COLUMN latitude REAL",
+        "ALTER TABLE contacts_data ADD COLUMN longitude REAL",
+        "ALTER TABLE contacts_data ADD COLUMN distance_km REAL",
+        "CREATE INDEX IF NOT EXISTS idx_distance ON contacts_data(distance_km)",
+        "CREATE VIRTUAL TABLE IF NOT EXISTS contacts_geo USING rtree(id, min_lat, max_lat, min_lon, max_lon)",
+        "CREATE TRIGGER IF NOT EXISTS contacts_geo_insert AFTER INSERT ON contacts_data "
+            "WHEN NEW.latitude IS NOT NULL BEGIN "
+            "INSERT INTO contacts_geo VALUES (NEW.id, NEW.latitude, NEW.latitude, NEW.longitude, NEW.longitude); END",
+        "CREATE TRIGGER IF NOT EXISTS contacts_geo_update AFTER UPDATE OF latitude, longitude ON contacts_data BEGIN "
+            "DELETE FROM contacts_geo WHERE id = OLD.id; "
+            "INSERT INTO contacts_geo SELECT NEW.id, NEW.latitude, NEW.latitude, NEW.longitude, NEW.longitude "
+            "WHERE NEW.latitude IS NOT NULL; END",
+        "CREATE TRIGGER IF NOT EXISTS contacts_geo_delete AFTER DELETE ON contacts_data BEGIN "
+            "DELETE FROM contacts_geo WHERE id = OLD.id; END",
+        "DROP VIEW contacts",
+        R"(
+            CREATE VIEW contacts AS
+            SELECT c.id, c.datetime, c.datetime_utc, c.callsign,
+                   c.band_id, b.name AS band, c.mode_id, m.name AS mode,
+                   c.rst_sent, c.rst_received, c.dxcc, c.locator,
+                   c.operator_id, o.name AS operator_call, c.import_batch, c.created_at,
+                   c.latitude, c.longitude, c.distance_km
+            FROM contacts_data c
+            JOIN dict_band b ON b.id = c.band_id
+            JOIN dict_mode m ON m.id = c.mode_id
+            JOIN dict_operator o ON o.id = c.operator_id
+        )"
+    };
+    
+    for (const QString &statement : statements) {
+        if (!execQuery(query, statement)) {
+            m_lastError = "Errore creazione indice geografico: " + query.lastError().text();
+            return false;
+        }
+    }
+    
+    // Coordinate dei QSO esistenti: la decodifica del locatore è in C++,
+    // i trigger appena creati riempiono l'R*Tree
+    QList<QPair<int, QString>> locators;
+    execQuery(query, "SELECT id, locator FROM contacts_data WHERE locator IS NOT NULL AND locator <> ''");
+    while (query.next()) {
+        locators.append({query.value(0).toInt(), query.value(1).toString()});
+    }
+    
+    query.prepare("UPDATE contacts_data SET latitude = ?, longitude = ?, distance_km = ? WHERE id = ?");
+    for (const auto &locator : locators) {
+        const QVariantList values = geoValues(locator.second);
+        if (values.first().isNull()) {
+            continue;
+        }
+        
+        for (const QVariant &value : values) {
+            query.addBindValue(value);
+        }
+        query.addBindValue(locator.first);
+        
+        if (!execQuery(query)) {
+            m_lastError = "Errore calcolo coordinate dei locatori: " + query.lastError().text();
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+QList<Database::StatisticsCounter> Database::statisticsCounters()
+{
+    // Tabella, tipo della chiave, espressione della chiave, condizione per
+    // contare la riga e dizionario dei nomi; %1 è NEW/OLD nei trigger e
+    // contacts_data nella ricostruzione
+    return {
+        {"stats_band", "INTEGER", "%1.band_id", "1", BandDictionary},
+        {"stats_mode", "INTEGER", "%1.mode_id", "1", ModeDictionary},
+        {"stats_dxcc", "TEXT", "%1.dxcc", "%1.dxcc IS NOT NULL AND %1.dxcc != ''", NoDictionary},
+        // Giorno UTC come numero di giorni dall'epoch; esclude righe senza epoch
+        {"stats_day", "INTEGER", "%1.datetime_utc / 86400", "%1.datetime_utc >= 0", NoDictionary}
+    };
+}
+
+bool Database::migrateToStatisticsTables()
+{
+    // Contatori per banda, modo, DXCC e giorno mantenuti da trigger, così le
+    // statistiche costano O(valori distinti) e non O(QSO). Tabelle e trigger
+    // vengono ricreati da zero: il tipo delle chiavi può essere cambiato
+    QSqlQuery query(m_db);
+    QStringList increments;
+    QStringList decrements;
+    
+    for (const StatisticsCounter &counter : statisticsCounters()) {
+        const QString table = counter.table;
+        const QString key = counter.keyExpression;
+        const QString condition = counter.condition;
+        
+        QString sql = QString("CREATE TABLE %1 (value %2 PRIMARY KEY, count INTEGER NOT NULL) WITHOUT ROWID")
+            .arg(table, counter.keyType);
+        if (!execQuery(query, "DROP TABLE IF EXISTS " + table) || !execQuery(query, sql)) {
+            m_lastError = "Errore creazione tabella " + table + ": " + query.lastError().text();
+            return false;
+        }
+        
+        increments.append(QString("INSERT INTO %1 (value, count) SELECT %2, 1 WHERE %3 "
+                                  "ON CONFLICT(value) DO UPDATE SET count = count + 1;")
+            .arg(table, key.arg("NEW"), condition.arg("NEW")));
+        decrements.append(QString("UPDATE %1 SET count = count - 1 WHERE value = %2 AND %3; "
+                                  "DELETE FROM %1 WHERE value = %2 AND count <= 0;")
+            .arg(table, key.arg("OLD"), condition.arg("OLD")));
+    }
+    
+    const QStringList triggers = {
+        "CREATE TRIGGER contacts_stats_insert AFTER INSERT ON contacts_data BEGIN "
+            + increments.join(" ") + " END",
+        "CREATE TRIGGER contacts_stats_delete AFTER DELETE ON contacts_data BEGIN "
+            + decrements.join(" ") + " END",
+        // Anche la conversione a epoch (backfill) passa di qui e popola stats_day
+        "CREATE TRIGGER contacts_stats_update AFTER UPDATE OF datetime_utc, band_id, mode_id, dxcc ON contacts_data BEGIN "
+            + decrements.join(" ") + " " + increments.join(" ") + " END"
+    };
+    
+    for (const QString &trigger : triggers) {
+        if (!execQuery(query, trigger)) {
+            m_lastError = "Errore creazione trigger statistiche: " + query.lastError().text();
+            return false;
+        }
+    }
+    
+    return fillStatisticsTables();
+}
+
+bool Database::fillStatisticsTables()
+{
+    QSqlQuery query(m_db);
+    
+    for (const StatisticsCounter &counter : statisticsCounters()) {
+        const QString table = counter.table;
+        const QString key = QString(counter.keyExpression).arg("contacts_data");
+        const QString condition = QString(counter.condition).arg("contacts_data");
+        
+        if (!execQuery(query, "DELETE FROM " + table)
+            || !execQuery(query, QString("INSERT INTO %1 (value, count) SELECT %2, COUNT(*) FROM contacts_data WHERE %3 GROUP BY 1")
+                   .arg(table, key, condition))) {
+            m_lastError = "Errore ricostruzione " + table + ": " + query.lastError().text();
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+const char *Database::dictionaryTable(Dictionary dictionary)
+{
+    switch (dictionary) {
+    case BandDictionary:
+        return "dict_band";
+    case ModeDictionary:
+        return "dict_mode";
+    case OperatorDictionary:
+        return "dict_operator";
+    default:
+        return nullptr;
+    }
+}
+
+int Database::lookupDictionaryId(Dictionary dictionary, const QString &name) const
+{
+    QMutexLocker locker(&m_dictionaryMutex);
+    loadDictionary(dictionary);
+    return dictionaryCache(dictionary).ids.value(name, -1);
+}
+
+int Database::dictionaryId(Dictionary dictionary, const QString &name)
+{
+    QMutexLocker locker(&m_dictionaryMutex);
+    loadDictionary(dictionary);
+    
+    DictionaryCache &cache = dictionaryCache(dictionary);
+    const auto it = cache.ids.constFind(name);
+    if (it != cache.ids.constEnd()) {
+        return it.value();
+    }
+    
+    // Valore nuovo: lo aggiunge al dizionario e ne legge l'id. La cache è
+    // condivisa tra le connessioni, quindi la chiamata deve avvenire fuori da
+    // una transazione: l'id pubblicato è già stato scritto (vedi addContacts)
+    const QString table = dictionaryTable(dictionary);
+    QSqlQuery query(m_db);
+    query.prepare(QString("INSERT OR IGNORE INTO %1 (name) VALUES (?)").arg(table));
+    query.addBindValue(name);
+    
+    if (!execQuery(query)) {
+        m_lastError = "Errore inserimento in " + table + ": " + query.lastError().text();
+        return -1;
+    }
+    
+    query.prepare(QString("SELECT id FROM %1 WHERE name = ?").arg(table));
+    query.addBindValue(name);
+    
+    if (!execQuery(query) || !query.next()) {
+        m_lastError = "Errore lettura da " + table + ": " + query.lastError().text();
+        return -1;
+    }
+    
+    const int id = query.value(0).toInt();
+    cache.ids.insert(name, id);
+    cache.names.insert(id, name);
+    return id;
+}
+
+QString Database::dictionaryName(Dictionary dictionary, int id) const
+{
+    QMutexLocker locker(&m_dictionaryMutex);
+    
+    DictionaryCache &cache = dictionaryCache(dictionary);
+    auto it = cache.names.constFind(id);
+    if (it == cache.names.constEnd()) {
+        // Id aggiunto da un'altra connessione: ricarica il dizionario
+        cache.loaded = false;
+        loadDictionary(dictionary);
+        it = cache.names.constFind(id);
+    }
+    
+    return it != cache.names.constEnd() ? it.value() : QString();
+}
+
+void Database::loadDictionary(Dictionary dictionary) const
+{
+    // Da chiamare con m_dictionaryMutex acquisito. I dizionari hanno poche
+    // decine di voci: si caricano per intero alla prima richiesta
+    DictionaryCache &cache = dictionaryCache(dictionary);
+    if (cache.loaded) {
+        return;
+    }
+    
+    QSqlQuery query(m_db);
+    execQuery(query, QString("SELECT id, name FROM %1").arg(dictionaryTable(dictionary)));
+    while (query.next()) {
+        const int id = query.value(0).toInt();
+        const QString name = query.value(1).toString();
+        cache.ids.insert(name, id);
+        cache.names.insert(id, name);
+    }
+    cache.loaded = query.isActive();
+}
+
+Database::DictionaryCache &Database::dictionaryCache(Dictionary dictionary) const
+{
+    // Da chiamare con m_dictionaryMutex acquisito. Gli id sono propri di
+    // ciascun file: una cache per logbook
+    return m_dictionaryCaches[m_cacheKey].dictionaries[dictionary];
+}
+
+void Database::invalidateDictionaryCache() const
+{
+    QMutexLocker locker(&m_dictionaryMutex);
+    m_dictionaryCaches.remove(m_cacheKey);
+}
+
+int Database::backfillEpochBatch(int batchSize)
+{
+    // Converte in SQL un lotto di righe senza epoch; le date non valide
+    // ricevono InvalidEpoch così da non essere riprese al lotto successivo
+    QSqlQuery query(m_db);
+    
+    QString sql = R"(
+        UPDATE contacts_data
+        SET datetime_utc = COALESCE(CAST(strftime('%s', datetime) AS INTEGER), ?)
+        WHERE id IN (SELECT id FROM contacts_data WHERE datetime_utc IS NULL LIMIT ?)
+    )";
+    
+    query.prepare(sql);
+    query.addBindValue(Contact::InvalidEpoch);
+    query.addBindValue(batchSize);
+    
+    if (!execQuery(query)) {
+        m_lastError = "Errore conversione date in epoch: " + query.lastError().text();
+        return -1;
+    }
+    
+    return query.numRowsAffected();
+}
+
+double Database::StorageStatistics::statisticsDrift() const
+{
+    if (analyzedRows < 0) {
+        return currentRows > 0 ? 1.0 : 0.0;
+    }
+    return double(qAbs(currentRows - analyzedRows)) / double(qMax<qint64>(analyzedRows, 1));
+}
+
+Database::AutoVacuumMode Database::autoVacuumMode() const
+{
+    QSqlQuery query(m_db);
+    if (execQuery(query, "PRAGMA auto_vacuum") && query.next()) {
+        return static_cast<AutoVacuumMode>(query.value(0).toInt());
+    }
+    return NoAutoVacuum;
+}
+
+Database::StorageStatistics Database::storageStatistics(bool measureFragmentation) const
+{
+    StorageStatistics statistics;
+    statistics.autoVacuum = autoVacuumMode();
+    statistics.currentRows = getTotalContacts();
+    
+    QSqlQuery query(m_db);
+    if (execQuery(query, "PRAGMA page_size") && query.next()) {
+        statistics.pageSize = query.value(0).toInt();
+    }
+    if (execQuery(query, "PRAGMA page_count") && query.next()) {
+        statistics.pageCount = query.value(0).toLongLong();
+    }
+    if (execQuery(query, "PRAGMA freelist_count") && query.next()) {
+        statistics.freelistCount = query.value(0).toLongLong();
+    }
+    
+    // La prima cifra di sqlite_stat1 è il numero di righe della tabella al
+    // momento dell'ultimo ANALYZE (stimato, con analysis_limit)
+    if (execQuery(query, "SELECT name FROM sqlite_master WHERE name = 'sqlite_stat1'") && query.next()) {
+        if (execQuery(query, "SELECT stat FROM sqlite_stat1 WHERE tbl = 'contacts_data' LIMIT 1") && query.next()) {
+            statistics.analyzedRows = query.value(0).toString().section(' ', 0, 0).toLongLong();
+        }
+    }
+    
+    // dbstat elenca le pagine del B-tree nell'ordine di visita: ogni salto
+    // rispetto alla pagina precedente è una lettura non sequenziale. Il
+    // modulo è opzionale in SQLite; se manca la frammentazione resta -1
+    if (measureFragmentation
+        && execQuery(query, "SELECT pageno FROM dbstat WHERE name = 'contacts_data' ORDER BY path")) {
+        qint64 pages = 0;
+        qint64 jumps = 0;
+        qint64 previous = -1;
+        while (query.next()) {
+            const qint64 page = query.value(0).toLongLong();
+            if (previous >= 0 && page != previous + 1) {
+                jumps++;
+            }
+            previous = page;
+            pages++;
+        }
+        statistics.fragmentation = pages > 1 ? double(jumps) / double(pages - 1) : 0.0;
+    }
+    
+    return statistics;
+}
+
+int Database::incrementalVacuumStep(int maxPages)
+{
+    QSqlQuery query(m_db);
+    if (!execQuery(query, "PRAGMA freelist_count") || !query.next()) {
+        m_lastError = "Errore lettura freelist: " + query.lastError().text();
+        return -1;
+    }
+    
+    const int pages = int(qMin<qint64>(query.value(0).toLongLong(), maxPages));
+    if (pages <= 0 || autoVacuumMode() != IncrementalAutoVacuum) {
+        return 0;
+    }
+    
+    // incremental_vacuum libera una pagina per ogni sqlite3_step, ma il
+    // driver Qt esegue un solo passo per exec(): un exec per pagina, tutti
+    // nella stessa transazione così il WAL riceve un solo commit
+    if (!m_db.transaction()) {
+        m_lastError = "Errore avvio compattazione: " + m_db.lastError().text();
+        return -1;
+    }
+    
+    query.prepare("PRAGMA incremental_vacuum");
+    for (int i = 0; i < pages; ++i) {
+        if (!execQuery(query)) {
+            m_lastError = "Errore compattazione database: " + query.lastError().text();
+            m_db.rollback();
+            return -1;
+        }
+    }
+    
+    if (!m_db.commit()) {
+        m_lastError = "Errore commit compattazione: " + m_db.lastError().text();
+        m_db.rollback();
+        return -1;
+    }
+    
+    return pages;
+}
+
+bool Database::refreshQueryStatistics(bool *analyzed)
+{
+    const StorageStatistics statistics = storageStatistics();
+    const bool drifted = statistics.statisticsDrift() > StatisticsDriftThreshold;
+    if (analyzed) {
+        *analyzed = drifted;
+    }
+    
+    // analysis_limit limita le righe lette per indice: ANALYZE resta breve
+    // anche su logbook grandi, con statistiche approssimate ma sufficienti
+    QSqlQuery query(m_db);
+    execQuery(query, QString("PRAGMA analysis_limit = %1").arg(AnalysisLimit));
+    if (!execQuery(query, drifted ? "ANALYZE" : "PRAGMA optimize")) {
+        m_lastError = "Errore aggiornamento statistiche: " + query.lastError().text();
+        return false;
+    }
+    
+    return true;
+}
+
+bool Database::checkpointWal()
+{
+    // Il file si accorcia solo quando le pagine troncate escono dal WAL
+    QSqlQuery query(m_db);
+    if (!execQuery(query, "PRAGMA wal_checkpoint(PASSIVE)")) {
+        m_lastError = "Errore checkpoint WAL: " + query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool Database::createContactsTable()
+{
+    // Schema di partenza (versione 0); dalla versione 3 contacts è una vista
+    // su contacts_data e la struttura è gestita solo da migrateSchema()
+    if (schemaVersion() >= 3) {
+        return true;
+    }
+    
+    QSqlQuery query(m_db);
+    
+    QString sql = R"(
+        CREATE TABLE IF NOT EXISTS contacts (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            datetime TEXT NOT NULL,
+            datetime_utc INTEGER,
+            callsign TEXT NOT NULL,
+            band TEXT NOT NULL,
+            mode TEXT NOT NULL,
+            rst_sent TEXT NOT NULL,
+            rst_received TEXT NOT NULL,
+            dxcc TEXT,
+            locator TEXT,
+            operator_call TEXT NOT NULL,
+            created_at DATETIME DEFAULT CURRENT_TIMESTAMP
+        )
+    )";
+    
+    if (!execQuery(query, sql)) {
+        m_lastError = "Errore creazione tabella contacts: " + query.lastError().text();
+        return false;
+    }
+    
+    // Crea indici per migliorare le performance
+    execQuery(query, "CREATE INDEX IF NOT EXISTS idx_callsign ON contacts(callsign)");
+    execQuery(query, "CREATE INDEX IF NOT EXISTS idx_datetime ON contacts(datetime)");
+    execQuery(query, "CREATE INDEX IF NOT EXISTS idx_band ON contacts(band)");
+    execQuery(query, "CREATE INDEX IF NOT EXISTS idx_mode ON contacts(mode)");
+    execQuery(query, "CREATE INDEX IF NOT EXISTS idx_dxcc ON contacts(dxcc)");
+    
+    return true;
+}
+
+bool Database::createSettingsTable()
+{
+    QSqlQuery query(m_db);
+    
+    QString sql = R"(
+        CREATE TABLE IF NOT EXISTS settings (
+            key TEXT PRIMARY KEY,
+            value TEXT
+        )
+    )";
+    
+    if (!execQuery(query, sql)) {
+        m_lastError = "Errore creazione tabella settings: " + query.lastError().text();
+        return false;
+    }
+    
+    return true;
+}
+
+bool Database::addContact(Contact &contact)
+{
+    const int bandId = dictionaryId(BandDictionary, contact.band());
+    const int modeId = dictionaryId(ModeDictionary, contact.mode());
+    const int operatorId = dictionaryId(OperatorDictionary, contact.operatorCall());
+    if (bandId < 0 || modeId < 0 || operatorId < 0) {
+        return false;
+    }
+    
+    QSqlQuery query(m_db);
+    
+    QString sql = R"(
+        INSERT INTO contacts_data 
+        (datetime, datetime_utc, callsign, band_id, mode_id, rst_sent, rst_received, dxcc, locator, operator_id, import_batch,
+         latitude, longitude, distance_km)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+    )";
+    
+    query.prepare(sql);
+    query.addBindValue(contact.dateTime().toString(Qt::ISODate));
+    query.addBindValue(contact.utcEpoch());
+    query.addBindValue(contact.callsign());
+    query.addBindValue(bandId);
+    query.addBindValue(modeId);
+    query.addBindValue(contact.rstSent());
+    query.addBindValue(contact.rstReceived());
+    query.addBindValue(contact.dxcc());
+    query.addBindValue(contact.locator());
+    query.addBindValue(operatorId);
+    query.addBindValue(m_importBatch > 0 ? QVariant(m_importBatch) : QVariant());
+    for (const QVariant &value : geoValues(contact.locator())) {
+        query.addBindValue(value);
+    }
+    
+    if (!execQuery(query)) {
+        m_lastError = "Errore inserimento contatto: " + query.lastError().text();
+        return false;
+    }
+    
+    // Imposta l'ID del contatto appena inserito
+    contact.setId(query.lastInsertId().toInt());
+    notifyContactsChanged();
+    
+    return true;
+}
+
+int Database::addContacts(QList<Contact> &contacts, const QString &importSource)
+{
+    // Le voci nuove dei dizionari si scrivono prima della transazione, ognuna
+    // con il proprio commit: la cache condivisa tra le connessioni riceve solo
+    // id già visibili alle altre, anche se il lotto viene poi annullato
+    for (const Contact &contact : std::as_const(contacts)) {
+        if (dictionaryId(BandDictionary, contact.band()) < 0
+            || dictionaryId(ModeDictionary, contact.mode()) < 0
+            || dictionaryId(OperatorDictionary, contact.operatorCall()) < 0) {
+            return 0; // m_lastError già impostato da dictionaryId()
+        }
+    }
+    
+    // Una sola transazione per tutto il lotto (es. importazione ADIF)
+    // e una sola notifica alla fine
+    const bool inTransaction = m_db.transaction();
+    
+    // Con una sorgente i contatti vengono registrati come lotto di importazione
+    if (!importSource.isEmpty()) {
+        QSqlQuery query(m_db);
+        query.prepare("INSERT INTO import_batches (source) VALUES (?)");
+        query.addBindValue(importSource);
+        if (execQuery(query)) {
+            m_importBatch = query.lastInsertId().toLongLong();
+        } else {
+            qWarning() << "Errore creazione lotto di importazione:" << query.lastError().text();
+        }
+    }
+    
+    int added = 0;
+    m_batchDepth++;
+    for (Contact &contact : contacts) {
+        if (addContact(contact)) {
+            added++;
+        }
+    }
+    m_batchDepth--;
+    m_importBatch = 0;
+    
+    if (inTransaction && !m_db.commit()) {
+        m_lastError = "Errore commit importazione: " + m_db.lastError().text();
+        m_db.rollback();
+        return 0;
+    }
+    
+    if (added > 0) {
+        notifyContactsChanged();
+    }
+    return added;
+}
+
+bool Database::updateContact(const Contact &contact)
+{
+    const int bandId = dictionaryId(BandDictionary, contact.band());
+    const int modeId = dictionaryId(ModeDictionary, contact.mode());
+    const int operatorId = dictionaryId(OperatorDictionary, contact.operatorCall());
+    if (bandId < 0 || modeId < 0 || operatorId < 0) {
+        return false;
+    }
+    
+    QSqlQuery query(m_db);
+    
+    QString sql = R"(
+        UPDATE contacts_data SET
+        datetime = ?, datetime_utc = ?, callsign = ?, band_id = ?, mode_id = ?,
+        rst_sent = ?, rst_received = ?, dxcc = ?, locator = ?, operator_id = ?,
+        latitude = ?, longitude = ?, distance_km = ?
+        WHERE id = ?
+    )";
+    
+    query.prepare(sql);
+    query.addBindValue(contact.dateTime().toString(Qt::ISODate));
+    query.addBindValue(contact.utcEpoch());
+    query.addBindValue(contact.callsign());
+    query.addBindValue(bandId);
+    query.addBindValue(modeId);
+    query.addBindValue(contact.rstSent());
+    query.addBindValue(contact.rstReceived());
+    query.addBindValue(contact.dxcc());
+    query.addBindValue(contact.locator());
+    query.addBindValue(operatorId);
+    for (const QVariant &value : geoValues(contact.locator())) {
+        query.addBindValue(value);
+    }
+    query.addBindValue(contact.id());
+    
+    if (!execQuery(query)) {
+        m_lastError = "Errore aggiornamento contatto: " + query.lastError().text();
+        return false;
+    }
+    
+    notifyContactsChanged();
+    return true;
+}
+
+bool Database::deleteContact(int contactId)
+{
+    QSqlQuery query(m_db);
+    
+    query.prepare("DELETE FROM contacts_data WHERE id = ?");
+    query.addBindValue(contactId);
+    
+    if (!execQuery(query)) {
+        m_lastError = "Errore eliminazione contatto: " + query.lastError().text();
+        return false;
+    }
+    
+    notifyContactsChanged();
+    return true;
+}
+
+bool Database::deleteContacts(const QList<int> &contactIds)
+{
+    return runChunked(contactIds, "DELETE FROM contacts_data WHERE id IN (%1)", QVariantList(),
+                      "Errore eliminazione contatti: ");
+}
+
+bool Database::updateField(const QList<int> &contactIds, ContactField field, const QString &value)
+{
+    QString column;
+    QVariant boundValue = value;
+    
+    // Banda, modo e operatore si aggiornano tramite l'id del dizionario
+    switch (field) {
+    case CallsignField:
+        column = "callsign";
+        boundValue = value.toUpper();
+        break;
+    case BandField:
+        column = "band_id";
+        boundValue = dictionaryId(BandDictionary, value);
+        break;
+    case ModeField:
+        column = "mode_id";
+        boundValue = dictionaryId(ModeDictionary, value);
+        break;
+    case RstSentField:
+        column = "rst_sent";
+        break;
+    case RstReceivedField:
+        column = "rst_received";
+        break;
+    case DxccField:
+        column = "dxcc";
+        break;
+    case LocatorField:
+        column = "locator";
+        break;
+    case OperatorField:
+        column = "operator_id";
+        boundValue = dictionaryId(OperatorDictionary, value.toUpper());
+        break;
+    }
+    
+    if (boundValue.userType() == QMetaType::Int && boundValue.toInt() < 0) {
+        return false; // m_lastError già impostato da dictionaryId()
+    }
+    
+    // Le coordinate seguono il locatore
+    QString assignments = column + " = ?";
+    QVariantList boundValues = {boundValue};
+    if (field == LocatorField) {
+        assignments += ", latitude = ?, longitude = ?, distance_km = ?";
+        boundValues += geoValues(value);
+    }
+    
+    return runChunked(contactIds, QString("UPDATE contacts_data SET %1 WHERE id IN (%2)").arg(assignments, "%1"),
+                      boundValues, "Errore aggiornamento contatti: ");
+}
+
+bool Database::deleteImportBatch(qint64 importBatch)
+{
+    // Contatti e lotto nella stessa transazione: o spariscono entrambi o
+    // nessuno dei due. I trigger del registro modifiche vedono le cancellazioni
+    // come quelle di deleteContacts, con una sola notifica
+    if (!m_db.transaction()) {
+        m_lastError = "Errore eliminazione lotto di importazione: " + m_db.lastError().text();
+        return false;
+    }
+    
+    QSqlQuery query(m_db);
+    query.prepare("DELETE FROM contacts_data WHERE import_batch = ?");
+    query.addBindValue(importBatch);
+    bool ok = execQuery(query);
+    
+    if (ok) {
+        query.prepare("DELETE FROM import_batches WHERE id = ?");
+        query.addBindValue(importBatch);
+        ok = execQuery(query);
+    }
+    
+    if (!ok) {
+        m_lastError = "Errore eliminazione lotto di importazione: " + query.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+    
+    if (!m_db.commit()) {
+        m_lastError = "Errore eliminazione lotto di importazione: " + m_db.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+    
+    notifyContactsChanged();
+    return true;
+}
+
+QList<Database::ImportBatch> Database::getImportBatches() const
+{
+    QList<ImportBatch> batches;
+    QSqlQuery query(m_db);
+    execQuery(query, R"(
+        SELECT b.id, b.source, b.created_at, COUNT(c.id)
+        FROM import_batches b
+        LEFT JOIN contacts_data c ON c.import_batch = b.id
+        GROUP BY b.id
+        ORDER BY b.id DESC
+    )");
+    
+    while (query.next()) {
+        ImportBatch batch;
+        batch.id = query.value(0).toLongLong();
+        batch.source = query.value(1).toString();
+        batch.createdAt = QDateTime::fromString(query.value(2).toString(), "yyyy-MM-dd HH:mm:ss");
+        batch.createdAt.setTimeZone(QTimeZone::utc());
+        batch.contactCount = query.value(3).toInt();
+        batches.append(batch);
+    }
+    
+    return batches;
+}
+
+bool Database::runChunked(const QList<int> &contactIds, const QString &sqlTemplate,
+                          const QVariantList &leadingValues, const QString &errorPrefix)
+{
+    if (contactIds.isEmpty()) {
+        return true;
+    }
+    
+    // Tutto o niente: un errore a metà annulla anche i blocchi già eseguiti
+    if (!m_db.transaction()) {
+        m_lastError = errorPrefix + m_db.lastError().text();
+        return false;
+    }
+    
+    QSqlQuery query(m_db);
+    for (qsizetype start = 0; start < contactIds.size(); start += MaxIdsPerStatement) {
+        const QList<int> chunk = contactIds.mid(start, MaxIdsPerStatement);
+        
+        QStringList placeholders;
+        placeholders.reserve(chunk.size());
+        for (qsizetype i = 0; i < chunk.size(); ++i) {
+            placeholders.append("?");
+        }
+        
+        query.prepare(sqlTemplate.arg(placeholders.join(", ")));
+        for (const QVariant &value : leadingValues) {
+            query.addBindValue(value);
+        }
+        for (int contactId : chunk) {
+            query.addBindValue(contactId);
+        }
+        
+        if (!execQuery(query)) {
+            m_lastError = errorPrefix + query.lastError().text();
+            m_db.rollback();
+            invalidateDictionaryCache();
+            return false;
+        }
+    }
+    
+    if (!m_db.commit()) {
+        m_lastError = errorPrefix + m_db.lastError().text();
+        m_db.rollback();
+        invalidateDictionaryCache();
+        return false;
+    }
+    
+    // Il modello riceve una sola notifica per tutta l'operazione
+    notifyContactsChanged();
+    return true;
+}
+
+Contact Database::getContact(int contactId) const
+{
+    QSqlQuery query(m_db);
+    
+    query.prepare("SELECT * FROM contacts WHERE id = ?");
+    query.addBindValue(contactId);
+    
+    if (execQuery(query) && query.next()) {
+        return contactFromQuery(query);
+    }
+    
+    return Contact();
+}
+
+Contact Database::contactFromQuery(const QSqlQuery &query) const
+{
+    Contact contact;
+    contact.setId(query.value("id").toInt());
+    
+    // Epoch intero se disponibile; il testo ISO solo per le righe non ancora convertite
+    const QVariant utcEpoch = query.value("datetime_utc");
+    if (!utcEpoch.isNull()) {
+        contact.setUtcEpoch(utcEpoch.toLongLong());
+    } else {
+        contact.setDateTime(QDateTime::fromString(query.value("datetime").toString(), Qt::ISODate));
+    }
+    
+    contact.setCallsign(query.value("callsign").toString());
+    contact.setBand(query.value("band").toString());
+    contact.setMode(query.value("mode").toString());
+    contact.setRstSent(query.value("rst_sent").toString());
+    contact.setRstReceived(query.value("rst_received").toString());
+    contact.setDxcc(query.value("dxcc").toString());
+    contact.setLocator(query.value("locator").toString());
+    contact.setOperatorCall(query.value("operator_call").toString());
+    return contact;
+}
+
+QList<Contact> Database::getAllContacts(bool includeArchives) const
+{
+    QList<Contact> contacts;
+    const QStringList archives = includeArchives ? attachArchives(archiveYears()) : QStringList();
+    QSqlQuery query(m_db);
+    execQuery(query, "SELECT * FROM " + contactSource(archives) + " ORDER BY datetime_utc DESC");
+    
+    while (query.next()) {
+        contacts.append(contactFromQuery(query));
+    }
+    
+    query.finish();
+    detachSchemas(archives);
+    return contacts;
+}
+
+QList<CompactContact> Database::getAllCompactContacts() const
+{
+    // Come getAllContacts, ma ogni riga diventa subito un record compatto:
+    // nessuna lista intermedia di Contact per l'intero log. Solo il database
+    // principale: è il contenuto della tabella nella finestra
+    QList<CompactContact> contacts;
+    QSqlQuery query(m_db);
+    execQuery(query, "SELECT * FROM contacts ORDER BY datetime_utc DESC");
+    
+    while (query.next()) {
+        contacts.append(CompactContact(contactFromQuery(query)));
+    }
+    
+    return contacts;
+}
+
+QList<Contact> Database::searchContacts(const QString &searchTerm, bool includeArchives) const
+{
+    QList<Contact> contacts;
+    const QStringList archives = includeArchives ? attachArchives(archiveYears()) : QStringList();
+    QSqlQuery query(m_db);
+    
+    QString sql = QString(R"(
+        SELECT * FROM %1 
+        WHERE callsign LIKE ? OR band LIKE ? OR mode LIKE ? OR dxcc LIKE ?
+        ORDER BY datetime_utc DESC
+    )").arg(contactSource(archives));
+    
+    query.prepare(sql);
+    QString term = "%" + searchTerm + "%";
+    query.addBindValue(term);
+    query.addBindValue(term);
+    query.addBindValue(term);
+    query.addBindValue(term);
+    
+    if (execQuery(query)) {
+        while (query.next()) {
+            contacts.append(contactFromQuery(query));
+        }
+    }
+    
+    query.finish();
+    detachSchemas(archives);
+    return contacts;
+}
+
+ContactCursor Database::openContactCursor(const ContactQuery &contactQuery) const
+{
+    // Gli archivi restano collegati finché il cursore non li rilascia
+    const QStringList archives = attachArchives(archiveYearsFor(contactQuery));
+    
+    QVariantList bindValues;
+    const QString sql = contactQuery.toSql(bindValues, contactSource(archives));
+    
+    // Solo avanti: il driver non conserva le righe già lette
+    QSqlQuery query(m_db);
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    for (const QVariant &value : bindValues) {
+        query.addBindValue(value);
+    }
+    
+    const bool ok = execQuery(query);
+    if (!ok) {
+        qWarning() << "Errore query contatti:" << query.lastError().text();
+    }
+    
+    return ContactCursor(this, query, ok, archives);
+}
+
+QList<Contact> Database::queryContacts(const ContactQuery &contactQuery) const
+{
+    QList<Contact> contacts;
+    ContactCursor cursor = openContactCursor(contactQuery);
+    
+    while (cursor.next()) {
+        contacts.append(cursor.contact());
+    }
+    
+    return contacts;
+}
+
+bool Database::execQuery(QSqlQuery &query, const QString &sql) const
+{
+    QueryProfiler &profiler = QueryProfiler::instance();
+    if (!profiler.isEnabled()) {
+        return sql.isNull() ? query.exec() : query.exec(sql);
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    const bool success = sql.isNull() ? query.exec() : query.exec(sql);
+    const qint64 micros = timer.nsecsElapsed() / 1000;
+    
+    // Le istruzioni preparate si raggruppano sul testo con i segnaposto,
+    // quindi un'istruzione ha un solo istogramma qualunque siano i valori
+    const QString statement = sql.isNull() ? query.lastQuery() : sql;
+    if (profiler.record(statement, micros)) {
+        const QVariantList bindValues = sql.isNull() ? query.boundValues() : QVariantList();
+        QStringList plan;
+        if (profiler.needsPlan(statement)) {
+            plan = explainStatement(statement, bindValues);
+        }
+        profiler.recordSlow(statement, micros, m_db.connectionName(),
+                            QueryProfiler::parameterShape(bindValues), plan);
+    }
+    
+    return success;
+}
+
+QStringList Database::explainStatement(const QString &sql, const QVariantList &bindValues) const
+{
+    // Stessa connessione e stessi valori: il piano è quello appena eseguito.
+    // Non strumentata, altrimenti un EXPLAIN lento ne richiederebbe un altro
+    QStringList plan;
+    QSqlQuery query(m_db);
+    if (!query.prepare("EXPLAIN QUERY PLAN " + sql)) {
+        return plan;
+    }
+    for (const QVariant &value : bindValues) {
+        query.addBindValue(value);
+    }
+    
+    if (query.exec()) {
+        while (query.next()) {
+            plan.append(query.value("detail").toString());
+        }
+    }
+    
+    return plan;
+}
+
+QStringList Database::explainContactQuery(const ContactQuery &contactQuery) const
+{
+    const QStringList archives = attachArchives(archiveYearsFor(contactQuery));
+    
+    QStringList plan;
+    QVariantList bindValues;
+    const QString sql = contactQuery.toSql(bindValues, contactSource(archives));
+    
+    QSqlQuery query(m_db);
+    query.prepare("EXPLAIN QUERY PLAN " + sql);
+    for (const QVariant &value : bindValues) {
+        query.addBindValue(value);
+    }
+    
+    if (execQuery(query)) {
+        while (query.next()) {
+            plan.append(query.value("detail").toString());
+        }
+    } else {
+        qWarning() << "Errore EXPLAIN QUERY PLAN:" << query.lastError().text();
+    }
+    
+    query.finish();
+    detachSchemas(archives);
+    return plan;
+}
+
+bool Database::verifyContactQueryPlan(const ContactQuery &contactQuery, QStringList *plan) const
+{
+    // Con predicati ogni SCAN è una lettura dell'intera tabella (anche se
+    // percorsa lungo un indice) e il piano deve usare solo "SEARCH".
+    // Senza predicati si accetta solo la scansione ordinata sull'indice.
+    // contacts è una vista: nel piano compare contacts_data con alias c
+    const QStringList details = explainContactQuery(contactQuery);
+    if (plan) {
+        *plan = details;
+    }
+    
+    if (details.isEmpty()) {
+        return false;
+    }
+    
+    for (const QString &detail : details) {
+        if (detail.startsWith("SCAN ")
+            && (!contactQuery.isEmpty() || !detail.contains("USING INDEX"))) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool Database::verifyContactQueryPlans(QStringList *report) const
+{
+    // Una query per forma: intervallo di tempo, insieme di bande e modi,
+    // prefisso del nominativo, DXCC, QSO successivi all'ultimo caricamento
+    // (intervallo aperto, in ordine crescente) e l'elenco completo
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    const qint64 lastUpload = now - 30 * 24 * 3600;
+    const QList<QPair<QString, ContactQuery>> queries = {
+        {"intervallo di tempo", ContactQuery().setEpochRange(now - 7 * 24 * 3600, now)},
+        {"bande e modi", ContactQuery().setBands({"20m", "40m"}).setModes({"CW", "SSB"})},
+        {"prefisso", ContactQuery().setCallsignPrefix("IK2")},
+        {"DXCC", ContactQuery().setDxcc("I")},
+        {"dall'ultimo caricamento", ContactQuery().setEpochRange(lastUpload).setSortOrder(Qt::AscendingOrder)},
+        {"elenco completo", ContactQuery().setLimit(100)}
+    };
+    
+    bool ok = true;
+    for (const auto &entry : queries) {
+        QStringList plan;
+        const bool planOk = verifyContactQueryPlan(entry.second, &plan);
+        ok = ok && planOk;
+        if (report) {
+            report->append(QString("%1 %2").arg(planOk ? "OK  " : "SCAN", entry.first));
+            for (const QString &detail : std::as_const(plan)) {
+                report->append("     " + detail);
+            }
+        }
+    }
+    
+    return ok;
+}
+
+QString Database::archiveDirectory(const QString &logbookPath)
+{
+    return QFileInfo(logbookPath).absolutePath() + "/archive";
+}
+
+QString Database::archivePath(const QString &logbookPath, int year)
+{
+    return archiveDirectory(logbookPath) + QString("/%1_%2.db").arg(logbookName(logbookPath)).arg(year);
+}
+
+QList<int> Database::archiveYears(const QString &logbookPath)
+{
+    // Più logbook possono stare nella stessa cartella: <logbook>_AAAA.db
+    QList<int> years;
+    const QString prefix = logbookName(logbookPath) + "_";
+    const QStringList names = QDir(archiveDirectory(logbookPath)).entryList(QStringList() << prefix + "????.db",
+                                                                            QDir::Files, QDir::Name);
+    
+    for (const QString &name : names) {
+        bool ok = false;
+        const int year = name.mid(prefix.size(), 4).toInt(&ok);
+        if (ok) {
+            years.append(year);
+        }
+    }
+    
+    return years;
+}
+
+qint64 Database::yearStartEpoch(int year)
+{
+    return QDateTime(QDate(year, 1, 1), QTime(0, 0), QTimeZone::utc()).toSecsSinceEpoch();
+}
+
+int Database::archiveContactsBefore(int cutoffYear)
+{
+    // Solo righe con epoch valido: quelle ancora da convertire restano nel
+    // database principale fino al backfill
+    const qint64 cutoffEpoch = yearStartEpoch(cutoffYear);
+    QList<int> years;
+    {
+        QSqlQuery query(m_db);
+        query.prepare(R"(
+            SELECT DISTINCT CAST(strftime('%Y', datetime_utc, 'unixepoch') AS INTEGER)
+            FROM contacts_data
+            WHERE datetime_utc > ? AND datetime_utc < ?
+        )");
+        query.addBindValue(Contact::InvalidEpoch);
+        query.addBindValue(cutoffEpoch);
+        
+        if (!execQuery(query)) {
+            m_lastError = "Errore lettura anni da archiviare: " + query.lastError().text();
+            return -1;
+        }
+        
+        while (query.next()) {
+            years.append(query.value(0).toInt());
+        }
+    }
+    
+    if (years.isEmpty()) {
+        return 0;
+    }
+    
+    QDir().mkpath(archiveDirectory());
+    
+    int moved = 0;
+    bool ok = true;
+    for (int year : years) {
+        if (!archiveYear(year, qMin(yearStartEpoch(year + 1), cutoffEpoch), &moved)) {
+            ok = false;
+            break;
+        }
+    }
+    
+    // Le cancellazioni passano dal registro modifiche come le altre
+    if (moved > 0) {
+        notifyContactsChanged();
+    }
+    
+    return ok ? moved : -1;
+}
+
+bool Database::archiveYear(int year, qint64 toEpoch, int *moved)
+{
+    // Due transazioni: prima la copia nell'archivio, poi la cancellazione dal
+    // database principale. Con WAL il commit su più file non è atomico; in
+    // quest'ordine un'interruzione lascia al più righe doppie, che il passaggio
+    // successivo ricopia (INSERT OR REPLACE) e toglie dal database principale
+    const qint64 fromEpoch = yearStartEpoch(year);
+    QSqlQuery query(m_db);
+    
+    query.prepare("ATTACH DATABASE ? AS archive_write");
+    query.addBindValue(archivePath(year));
+    if (!execQuery(query)) {
+        m_lastError = QString("Impossibile aprire l'archivio %1: %2").arg(year).arg(query.lastError().text());
+        return false;
+    }
+    
+    // Stessi id dei dizionari principali: i filtri per banda e modo delle
+    // query valgono anche sulle righe archiviate
+    const QStringList statements = {
+        "CREATE TABLE IF NOT EXISTS archive_write.dict_band (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE)",
+        "CREATE TABLE IF NOT EXISTS archive_write.dict_mode (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE)",
+        "CREATE TABLE IF NOT EXISTS archive_write.dict_operator (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE)",
+        R"(
+            CREATE TABLE IF NOT EXISTS archive_write.contacts_data (
+                id INTEGER PRIMARY KEY,
+                datetime TEXT NOT NULL,
+                datetime_utc INTEGER,
+                callsign TEXT NOT NULL,
+                band_id INTEGER NOT NULL REFERENCES dict_band(id),
+                mode_id INTEGER NOT NULL REFERENCES dict_mode(id),
+                rst_sent TEXT NOT NULL,
+                rst_received TEXT NOT NULL,
+                dxcc TEXT,
+                locator TEXT,
+                operator_id INTEGER NOT NULL REFERENCES dict_operator(id),
+                import_batch INTEGER,
+                created_at DATETIME
+            )
+        )",
+        R"(
+            CREATE VIEW IF NOT EXISTS archive_write.contacts AS
+            SELECT c.id, c.datetime, c.datetime_utc, c.callsign,
+                   c.band_id, b.name AS band, c.mode_id, m.name AS mode,
+                   c.rst_sent, c.rst_received, c.dxcc, c.locator,
+                   c.operator_id, o.name AS operator_call, c.import_batch, c.created_at
+            FROM contacts_data c
+            JOIN dict_band b ON b.id = c.band_id
+            JOIN dict_mode m ON m.id = c.mode_id
+            JOIN dict_operator o ON o.id = c.operator_id
+        )",
+        "CREATE INDEX IF NOT EXISTS archive_write.idx_callsign ON contacts_data(callsign)",
+        "CREATE INDEX IF NOT EXISTS archive_write.idx_datetime_utc ON contacts_data(datetime_utc)",
+        "CREATE INDEX IF NOT EXISTS archive_write.idx_band ON contacts_data(band_id)",
+        "CREATE INDEX IF NOT EXISTS archive_write.idx_mode ON contacts_data(mode_id)",
+        "CREATE INDEX IF NOT EXISTS archive_write.idx_dxcc ON contacts_data(dxcc)",
+        "CREATE INDEX IF NOT EXISTS archive_write.idx_dupe_utc ON contacts_data(callsign, band_id, mode_id, datetime_utc)",
+        "INSERT OR IGNORE INTO archive_write.dict_band SELECT id, name FROM main.dict_band",
+        "INSERT OR IGNORE INTO archive_write.dict_mode SELECT id, name FROM main.dict_mode",
+        "INSERT OR IGNORE INTO archive_write.dict_operator SELECT id, name FROM main.dict_operator"
+    };
+    
+    bool ok = execQuery(query, "BEGIN IMMEDIATE");
+    for (int i = 0; ok && i < statements.size(); ++i) {
+        ok = execQuery(query, statements.at(i));
+    }
+    
+    if (ok) {
+        query.prepare(QString("INSERT OR REPLACE INTO archive_write.contacts_data (%1) "
+                              "SELECT %1 FROM main.contacts_data WHERE datetime_utc >= ? AND datetime_utc < ?")
+                      .arg(ArchiveTableColumns));
+        query.addBindValue(fromEpoch);
+        query.addBindValue(toEpoch);
+        ok = execQuery(query) && execQuery(query, "COMMIT");
+    }
+    
+    if (ok) {
+        // Cancella solo ciò che è effettivamente nell'archivio
+        ok = execQuery(query, "BEGIN IMMEDIATE");
+        if (ok) {
+            query.prepare(R"(
+                DELETE FROM main.contacts_data
+                WHERE datetime_utc >= ? AND datetime_utc < ?
+                  AND id IN (SELECT id FROM archive_write.contacts_data)
+            )");
+            query.addBindValue(fromEpoch);
+            query.addBindValue(toEpoch);
+            ok = execQuery(query);
+        }
+        if (ok) {
+            const int deleted = query.numRowsAffected();
+            ok = execQuery(query, "COMMIT");
+            if (ok) {
+                *moved += deleted;
+            }
+        }
+    }
+    
+    if (!ok) {
+        m_lastError = QString("Errore archiviazione anno %1: %2").arg(year).arg(query.lastError().text());
+        execQuery(query, "ROLLBACK");
+    }
+    
+    execQuery(query, "DETACH DATABASE archive_write");
+    return ok;
+}
+
+QList<int> Database::archiveYearsFor(const ContactQuery &contactQuery) const
+{
+    if (contactQuery.includeArchives()) {
+        return archiveYears();
+    }
+    
+    // Altrimenti solo gli anni archiviati che ricadono nell'intervallo di
+    // tempo; senza intervallo la query resta sul database principale
+    QList<int> years;
+    const qint64 fromEpoch = contactQuery.fromEpoch();
+    const qint64 toEpoch = contactQuery.toEpoch();
+    if (fromEpoch == Contact::InvalidEpoch && toEpoch == Contact::InvalidEpoch) {
+        return years;
+    }
+    
+    const QList<int> archived = archiveYears();
+    for (int year : archived) {
+        if ((fromEpoch == Contact::InvalidEpoch || yearStartEpoch(year + 1) > fromEpoch)
+            && (toEpoch == Contact::InvalidEpoch || yearStartEpoch(year) < toEpoch)) {
+            years.append(year);
+        }
+    }
+    return years;
+}
+
+QStringList Database::attachArchives(const QList<int> &years) const
+{
+    // Ogni chiamata collega i propri schemi con un nome unico: un cursore
+    // aperto e una query sugli stessi anni non si pestano i piedi
+    QStringList schemas;
+    QSqlQuery query(m_db);
+    
+    for (int year : years) {
+        if (schemas.size() >= MaxAttachedDatabases) {
+            qWarning() << "Troppi archivi collegati, anno escluso dalla query:" << year;
+            continue;
+        }
+        
+        // URI con mode=ro: da questa connessione l'archivio non è modificabile
+        const QString schema = QString("archive_%1_%2").arg(year).arg(++m_archiveSerial);
+        query.prepare("ATTACH DATABASE ? AS " + schema);
+        query.addBindValue(QUrl::fromLocalFile(archivePath(year)).toString() + "?mode=ro");
+        
+        if (!execQuery(query)) {
+            qWarning() << "Impossibile collegare l'archivio" << year << ":" << query.lastError().text();
+            continue;
+        }
+        
+        schemas.append(schema);
+    }
+    
+    return schemas;
+}
+
+QString Database::contactSource(const QStringList &archiveSchemas)
+{
+    if (archiveSchemas.isEmpty()) {
+        return "contacts";
+    }
+    
+    // UNION ALL in sottoquery: SQLite spinge i predicati dentro ogni ramo e
+    // usa gli indici di ciascun file, l'ordinamento finale è un merge
+    const QString branch = QString("SELECT ") + ArchiveViewColumns + " FROM %1.contacts";
+    return "(" + unionAcross(branch, QStringList("main") + archiveSchemas) + ") AS contacts";
+}
+
+QString Database::unionAcross(const QString &branch, const QStringList &schemas)
+{
+    QStringList parts;
+    for (const QString &schema : schemas) {
+        parts.append(branch.arg(schema));
+    }
+    return parts.join(" UNION ALL ");
+}
+
+QStringList Database::attachLogbooks(const QStringList &logbookPaths, QStringList *names,
+                                     bool includeArchives, int attachedCount) const
+{
+    // Restituisce gli schemi collegati; names riceve i nomi dei logbook
+    // corrispondenti (anche per gli archivi, che appartengono al loro
+    // logbook). Il file della connessione stessa non si ricollega
+    QStringList schemas;
+    QSqlQuery query(m_db);
+    
+    for (const QString &path : logbookPaths) {
+        const QString key = QFileInfo(path).absoluteFilePath();
+        if (key == m_cacheKey || !QFileInfo::exists(key)) {
+            continue;
+        }
+        
+        QStringList files(key);
+        if (includeArchives) {
+            const QList<int> years = archiveYears(key);
+            for (int year : years) {
+                files.append(archivePath(key, year));
+            }
+        }
+        
+        for (const QString &file : std::as_const(files)) {
+            if (attachedCount + schemas.size() >= MaxAttachedDatabases) {
+                qWarning() << "Troppi database collegati, file escluso:" << file;
+                break;
+            }
+            
+            const QString schema = QString("logbook_%1").arg(schemas.size());
+            query.prepare("ATTACH DATABASE ? AS " + schema);
+            query.addBindValue(QUrl::fromLocalFile(file).toString() + "?mode=ro");
+            
+            if (!execQuery(query)) {
+                qWarning() << "Impossibile collegare il logbook" << file << ":" << query.lastError().text();
+                continue;
+            }
+            
+            schemas.append(schema);
+            if (names) {
+                names->append(logbookName(key));
+            }
+        }
+    }
+    
+    return schemas;
+}
+
+void Database::detachSchemas(const QStringList &schemas) const
+{
+    QSqlQuery query(m_db);
+    for (const QString &schema : schemas) {
+        if (!execQuery(query, "DETACH DATABASE " + schema)) {
+            qWarning() << "Impossibile scollegare" << schema << ":" << query.lastError().text();
+        }
+    }
+}
+
+QList<Database::WorkedEntry> Database::workedBeforeAcrossLogbooks(const QString &callsign,
+                                                                  const QStringList &logbookPaths) const
+{
+    QList<WorkedEntry> entries;
+    const QString call = callsign.trimmed().toUpper();
+    if (call.isEmpty()) {
+        return entries;
+    }
+    
+    // Il logbook corrente con i suoi archivi, poi gli altri con i loro
+    const QString currentName = logbookName(databasePath());
+    QStringList schemas("main");
+    QStringList names(currentName);
+    const QStringList archives = attachArchives(archiveYears());
+    for (const QString &archive : archives) {
+        schemas.append(archive);
+        names.append(currentName);
+    }
+    schemas.append(attachLogbooks(logbookPaths, &names, true, archives.size()));
+    
+    // Un ramo per file: ogni ramo usa idx_dupe_utc del proprio file e
+    // traduce gli id di banda e modo con i propri dizionari. Gli archivi
+    // dello stesso logbook si sommano nel raggruppamento esterno
+    const QString branch = R"(
+        SELECT ? AS logbook, b.name AS band, m.name AS mode,
+               COUNT(*) AS count, MAX(c.datetime_utc) AS last_epoch
+        FROM %1.contacts_data c
+        JOIN %1.dict_band b ON b.id = c.band_id
+        JOIN %1.dict_mode m ON m.id = c.mode_id
+        WHERE c.callsign = ?
+        GROUP BY c.band_id, c.mode_id
+    )";
+    
+    QSqlQuery query(m_db);
+    query.prepare(QString(R"(
+        SELECT logbook, band, mode, SUM(count) AS count, MAX(last_epoch) AS last_epoch FROM (%1)
+        GROUP BY logbook, band, mode
+        ORDER BY last_epoch DESC
+    )").arg(unionAcross(branch, schemas)));
+    for (const QString &name : names) {
+        query.addBindValue(name);
+        query.addBindValue(call);
+    }
+    
+    if (execQuery(query)) {
+        while (query.next()) {
+            WorkedEntry entry;
+            entry.logbook = query.value("logbook").toString();
+            entry.band = query.value("band").toString();
+            entry.mode = query.value("mode").toString();
+            entry.count = query.value("count").toInt();
+            entry.lastEpoch = query.value("last_epoch").toLongLong();
+            entries.append(entry);
+        }
+    } else {
+        qWarning() << "Errore ricerca tra logbook:" << query.lastError().text();
+    }
+    query.finish();
+    
+    schemas.removeFirst();
+    detachSchemas(schemas);
+    return entries;
+}
+
+Database::LogbookStatistics Database::getStatisticsAcrossLogbooks(const QStringList &logbookPaths) const
+{
+    LogbookStatistics statistics;
+    
+    QStringList schemas = attachLogbooks(logbookPaths, nullptr);
+    schemas.prepend("main");
+    
+    // Somma dei contatori mantenuti dai trigger in ciascun file
+    const QList<StatisticsCounter> counters = statisticsCounters();
+    statistics.bandCounts = readCounterAcross(counters.at(0), schemas);
+    statistics.modeCounts = readCounterAcross(counters.at(1), schemas);
+    statistics.dxccCounts = readCounterAcross(counters.at(2), schemas);
+    for (int count : std::as_const(statistics.bandCounts)) {
+        statistics.totalContacts += count;
+    }
+    
+    schemas.removeFirst();
+    detachSchemas(schemas);
+    return statistics;
+}
+
+QVariantList Database::geoValues(const QString &locator) const
+{
+    // Latitudine, longitudine e distanza dall'operatore; NULL se il locatore
+    // manca o non è valido, e la distanza se manca quello dell'operatore
+    double latitude = 0.0;
+    double longitude = 0.0;
+    if (!Maidenhead::toLatLon(locator, &latitude, &longitude)) {
+        return {QVariant(), QVariant(), QVariant()};
+    }
+    
+    QVariant distance;
+    double operatorLatitude = 0.0;
+    double operatorLongitude = 0.0;
+    if (Maidenhead::toLatLon(getOperatorData().locator, &operatorLatitude, &operatorLongitude)) {
+        distance = Maidenhead::distanceKm(operatorLatitude, operatorLongitude, latitude, longitude);
+    }
+    
+    return {latitude, longitude, distance};
+}
+
+Database::LocatedContact Database::locatedContactFromQuery(const QSqlQuery &query) const
+{
+    LocatedContact located;
+    located.contact = contactFromQuery(query);
+    located.latitude = query.value("latitude").toDouble();
+    located.longitude = query.value("longitude").toDouble();
+    
+    const QVariant distance = query.value("distance_km");
+    located.distanceKm = distance.isNull() ? -1.0 : distance.toDouble();
+    return located;
+}
+
+QList<Database::LocatedContact> Database::queryBoundingBoxes(const QList<Maidenhead::BoundingBox> &boxes) const
+{
+    // I punti dell'R*Tree intersecano il rettangolo se vi sono contenuti;
+    // l'R*Tree restituisce gli id, la vista il resto del contatto
+    QStringList parts;
+    QVariantList bindValues;
+    for (const Maidenhead::BoundingBox &box : boxes) {
+        parts.append("SELECT id FROM contacts_geo WHERE max_lat >= ? AND min_lat <= ? AND max_lon >= ? AND min_lon <= ?");
+        bindValues << box.minLatitude << box.maxLatitude << box.minLongitude << box.maxLongitude;
+    }
+    
+    QList<LocatedContact> contacts;
+    if (parts.isEmpty()) {
+        return contacts;
+    }
+    
+    QSqlQuery query(m_db);
+    query.prepare("SELECT * FROM contacts WHERE id IN (" + parts.join(" UNION ALL ") + ")");
+    for (const QVariant &value : bindValues) {
+        query.addBindValue(value);
+    }
+    
+    if (!execQuery(query)) {
+        qWarning() << "Errore query geografica:" << query.lastError().text();
+        return contacts;
+    }
+    
+    while (query.next()) {
+        contacts.append(locatedContactFromQuery(query));
+    }
+    
+    return contacts;
+}
+
+QList<Database::LocatedContact> Database::contactsInBoundingBox(double minLatitude, double maxLatitude,
+                                                               double minLongitude, double maxLongitude) const
+{
+    Maidenhead::BoundingBox box;
+    box.minLatitude = minLatitude;
+    box.maxLatitude = maxLatitude;
+    box.minLongitude = minLongitude;
+    box.maxLongitude = maxLongitude;
+    
+    if (minLongitude <= maxLongitude) {
+        return queryBoundingBoxes({box});
+    }
+    
+    // A cavallo dell'antimeridiano: due rettangoli
+    Maidenhead::BoundingBox eastern = box;
+    box.maxLongitude = 180.0;
+    eastern.minLongitude = -180.0;
+    return queryBoundingBoxes({box, eastern});
+}
+
+QList<Database::LocatedContact> Database::contactsWithinRadius(double latitude, double longitude, double radiusKm) const
+{
+    // L'R*Tree restringe ai rettangoli che contengono il cerchio, la distanza
+    // esatta scarta gli angoli. distanceKm diventa la distanza dal centro
+    QList<LocatedContact> contacts;
+    const QList<LocatedContact> candidates = queryBoundingBoxes(Maidenhead::boundingBoxes(latitude, longitude, radiusKm));
+    
+    for (LocatedContact located : candidates) {
+        located.distanceKm = Maidenhead::distanceKm(latitude, longitude, located.latitude, located.longitude);
+        if (located.distanceKm <= radiusKm) {
+            contacts.append(located);
+        }
+    }
+    
+    std::sort(contacts.begin(), contacts.end(), [](const LocatedContact &a, const LocatedContact &b) {
+        return a.distanceKm < b.distanceKm;
+    });
+    return contacts;
+}
+
+QList<Database::LocatedContact> Database::nearestContacts(double latitude, double longitude, int limit) const
+{
+    // L'R*Tree non ordina per distanza: raggio raddoppiato finché il cerchio
+    // contiene almeno limit QSO. Quelli nel cerchio sono i più vicini
+    QList<LocatedContact> contacts;
+    if (limit <= 0) {
+        return contacts;
+    }
+    
+    double radiusKm = NearestSearchStartKm;
+    forever {
+        contacts = contactsWithinRadius(latitude, longitude, radiusKm);
+        if (contacts.size() >= limit || radiusKm >= Maidenhead::HalfCircumferenceKm) {
+            break;
+        }
+        radiusKm = qMin(radiusKm * 2, Maidenhead::HalfCircumferenceKm);
+    }
+    
+    return contacts.mid(0, limit);
+}
+
+QList<Database::LocatedContact> Database::contactsBeyondDistance(double minDistanceKm) const
+{
+    // Distanza precalcolata dall'operatore: intervallo sull'indice idx_distance
+    QList<LocatedContact> contacts;
+    QSqlQuery query(m_db);
+    query.prepare("SELECT * FROM contacts WHERE distance_km >= ? ORDER BY distance_km DESC");
+    query.addBindValue(minDistanceKm);
+    
+    if (!execQuery(query)) {
+        qWarning() << "Errore query per distanza:" << query.lastError().text();
+        return contacts;
+    }
+    
+    while (query.next()) {
+        contacts.append(locatedContactFromQuery(query));
+    }
+    
+    return contacts;
+}
+
+QStringList Database::gridsWithinRadius(double latitude, double longitude, double radiusKm) const
 {
-    if (m_db.isOpen()) {
-        m_db.close();
+    QStringList grids;
+    for (const LocatedContact &located : contactsWithinRadius(latitude, longitude, radiusKm)) {
+        const QString grid = located.contact.locator().left(4).toUpper();
+        if (!grids.contains(grid)) {
+            grids.append(grid);
+        }
     }
+    
+    grids.sort();
+    return grids;
 }
 
-bool Database::createTables()
+bool Database::refreshOperatorDistances()
 {
-    if (!createContactsTable()) {
+    if (!m_db.transaction()) {
+        m_lastError = "Errore aggiornamento distanze: " + m_db.lastError().text();
         return false;
     }
     
-    if (!createSettingsTable()) {
+    if (!writeOperatorDistances(getOperatorData().locator)) {
+        m_db.rollback();
+        return false;
+    }
+    if (!m_db.commit()) {
+        m_lastError = "Errore aggiornamento distanze: " + m_db.lastError().text();
+        m_db.rollback();
         return false;
     }
     
     return true;
 }
 
-bool Database::createContactsTable()
+bool Database::writeOperatorDistances(const QString &locator)
 {
-    QSqlQuery query(m_db);
+    double operatorLatitude = 0.0;
+    double operatorLongitude = 0.0;
+    const bool located = Maidenhead::toLatLon(locator, &operatorLatitude, &operatorLongitude);
     
-    QString sql = R"(
-        CREATE TABLE IF NOT EXISTS contacts (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            datetime TEXT NOT NULL,
-            callsign TEXT NOT NULL,
-            band TEXT NOT NULL,
-            mode TEXT NOT NULL,
-            rst_sent TEXT NOT NULL,
-            rst_received TEXT NOT NULL,
-            dxcc TEXT,
-            locator TEXT,
-            operator_call TEXT NOT NULL,
-            created_at DATETIME DEFAULT CURRENT_TIMESTAMP
-        )
-    )";
+    // distance_km non è tra le colonne del registro modifiche: nessuna
+    // notifica, la tabella dei contatti non mostra la distanza
+    QSqlQuery query(m_db);
+    if (!located) {
+        if (!execQuery(query, "UPDATE contacts_data SET distance_km = NULL")) {
+            m_lastError = "Errore aggiornamento distanze: " + query.lastError().text();
+            return false;
+        }
+        return true;
+    }
     
-    if (!query.exec(sql)) {
-        m_lastError = "Errore creazione tabella contacts: " + query.lastError().text();
+    QList<int> ids;
+    QList<double> distances;
+    if (!execQuery(query, "SELECT id, latitude, longitude FROM contacts_data WHERE latitude IS NOT NULL")) {
+        m_lastError = "Errore aggiornamento distanze: " + query.lastError().text();
         return false;
     }
-    
-    // Crea indici per migliorare le performance
-    query.exec("CREATE INDEX IF NOT EXISTS idx_callsign ON contacts(callsign)");
-    query.exec("CREATE INDEX IF NOT EXISTS idx_datetime ON contacts(datetime)");
-    query.exec("CREATE INDEX IF NOT EXISTS idx_band ON contacts(band)");
-    query.exec("CREATE INDEX IF NOT EXISTS idx_mode ON contacts(mode)");
+    while (query.next()) {
+        ids.append(query.value(0).toInt());
+        distances.append(Maidenhead::distanceKm(operatorLatitude, operatorLongitude,
+                                                query.value(1).toDouble(), query.value(2).toDouble()));
+    }
+    query.finish();
+    
+    // Un'istruzione preparata per riga, tutte nella transazione del chiamante:
+    // un solo commit, nessuna sincronizzazione del file per riga
+    query.prepare("UPDATE contacts_data SET distance_km = ? WHERE id = ?");
+    for (qsizetype i = 0; i < ids.size(); ++i) {
+        query.addBindValue(distances.at(i));
+        query.addBindValue(ids.at(i));
+        if (!execQuery(query)) {
+            m_lastError = "Errore aggiornamento distanze: " + query.lastError().text();
+            return false;
+        }
+    }
     
     return true;
 }
 
-bool Database::createSettingsTable()
+QList<Contact> Database::findDuplicates(const Contact &contact, qint64 windowSeconds) const
 {
-    QSqlQuery query(m_db);
-    
-    QString sql = R"(
-        CREATE TABLE IF NOT EXISTS settings (
-            key TEXT PRIMARY KEY,
-            value TEXT
-        )
-    )";
+    QList<Contact> duplicates;
     
-    if (!query.exec(sql)) {
-        m_lastError = "Errore creazione tabella settings: " + query.lastError().text();
-        return false;
+    // Banda o modo mai usati: nessun duplicato possibile
+    const int bandId = lookupDictionaryId(BandDictionary, contact.band());
+    const int modeId = lookupDictionaryId(ModeDictionary, contact.mode());
+    if (!contact.hasDateTime() || bandId < 0 || modeId < 0) {
+        return duplicates;
     }
     
-    return true;
-}
-
-bool Database::addContact(Contact &contact)
-{
     QSqlQuery query(m_db);
     
+    // Uguaglianza sui primi tre campi e intervallo sul quarto: usa idx_dupe_utc
     QString sql = R"(
-        INSERT INTO contacts 
-        (datetime, callsign, band, mode, rst_sent, rst_received, dxcc, locator, operator_call)
-        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
+        SELECT * FROM contacts
+        WHERE callsign = ? AND band_id = ? AND mode_id = ? AND datetime_utc BETWEEN ? AND ?
+        ORDER BY datetime_utc DESC
     )";
     
     query.prepare(sql);
-    query.addBindValue(contact.dateTime().toString(Qt::ISODate));
     query.addBindValue(contact.callsign());
-    query.addBindValue(contact.band());
-    query.addBindValue(contact.mode());
-    query.addBindValue(contact.rstSent());
-    query.addBindValue(contact.rstReceived());
-    query.addBindValue(contact.dxcc());
-    query.addBindValue(contact.locator());
-    query.addBindValue(contact.operatorCall());
+    query.addBindValue(bandId);
+    query.addBindValue(modeId);
+    query.addBindValue(contact.utcEpoch() - windowSeconds);
+    query.addBindValue(contact.utcEpoch() + windowSeconds);
     
-    if (!query.exec()) {
-        m_lastError = "Errore inserimento contatto: " + query.lastError().text();
-        return false;
+    if (execQuery(query)) {
+        while (query.next()) {
+            Contact duplicate = contactFromQuery(query);
+            if (duplicate.id() != contact.id()) {
+                duplicates.append(duplicate);
+            }
+        }
+    } else {
+        qWarning() << "Errore ricerca duplicati:" << query.lastError().text();
     }
     
-    // Imposta l'ID del contatto appena inserito
-    contact.setId(query.lastInsertId().toInt());
-    
-    return true;
+    return duplicates;
 }
 
-bool Database::updateContact(const Contact &contact)
+QList<Database::DupeSummary> Database::getDupeSummaries() const
 {
-    QSqlQuery query(m_db);
-    
-    QString sql = R"(
-        UPDATE contacts SET
-        datetime = ?, callsign = ?, band = ?, mode = ?,
-        rst_sent = ?, rst_received = ?, dxcc = ?, locator = ?, operator_call = ?
-        WHERE id = ?
+    QList<DupeSummary> summaries;
+    
+    // Scansione del solo indice idx_dupe_utc (coprente), senza leggere la tabella
+    // Raggruppa sugli id interi; i nomi arrivano dalla cache dei dizionari.
+    // Gli archivi copiano i dizionari con gli stessi id: ogni file si
+    // raggruppa sul proprio indice e i gruppi si fondono
+    const QStringList archives = attachArchives(archiveYears());
+    const QString branch = R"(
+        SELECT callsign, band_id, mode_id, MIN(datetime_utc) AS first_epoch, MAX(datetime_utc) AS last_epoch
+        FROM %1.contacts_data
+        GROUP BY callsign, band_id, mode_id
     )";
+    QSqlQuery query(m_db);
+    execQuery(query, QString(R"(
+        SELECT callsign, band_id, mode_id, MIN(first_epoch), MAX(last_epoch) FROM (%1)
+        GROUP BY callsign, band_id, mode_id
+    )").arg(unionAcross(branch, QStringList("main") + archives)));
     
-    query.prepare(sql);
-    query.addBindValue(contact.dateTime().toString(Qt::ISODate));
-    query.addBindValue(contact.callsign());
-    query.addBindValue(contact.band());
-    query.addBindValue(contact.mode());
-    query.addBindValue(contact.rstSent());
-    query.addBindValue(contact.rstReceived());
-    query.addBindValue(contact.dxcc());
-    query.addBindValue(contact.locator());
-    query.addBindValue(contact.operatorCall());
-    query.addBindValue(contact.id());
-    
-    if (!query.exec()) {
-        m_lastError = "Errore aggiornamento contatto: " + query.lastError().text();
-        return false;
+    while (query.next()) {
+        DupeSummary summary;
+        summary.callsign = query.value(0).toString();
+        summary.band = dictionaryName(BandDictionary, query.value(1).toInt());
+        summary.mode = dictionaryName(ModeDictionary, query.value(2).toInt());
+        summary.firstEpoch = query.value(3).isNull() ? Contact::InvalidEpoch : query.value(3).toLongLong();
+        summary.lastEpoch = query.value(4).isNull() ? Contact::InvalidEpoch : query.value(4).toLongLong();
+        summaries.append(summary);
     }
     
-    return true;
+    query.finish();
+    detachSchemas(archives);
+    return summaries;
 }
 
-bool Database::deleteContact(int contactId)
+QList<Database::AwardSummary> Database::getAwardSummaries() const
 {
+    QList<AwardSummary> summaries;
+    
+    // Una sola scansione aggregata per file, archivi compresi: i QSO
+    // archiviati contano ancora per i diplomi. Da qui in poi AwardTracker si
+    // aggiorna con i singoli contatti
+    const QStringList archives = attachArchives(archiveYears());
+    const QString branch = R"(
+        SELECT UPPER(TRIM(dxcc)) AS dxcc, UPPER(SUBSTR(TRIM(locator), 1, 4)) AS grid,
+               band_id, mode_id, COUNT(*) AS count
+        FROM %1.contacts_data
+        GROUP BY 1, 2, band_id, mode_id
+    )";
     QSqlQuery query(m_db);
+    execQuery(query, QString(R"(
+        SELECT dxcc, grid, band_id, mode_id, SUM(count) FROM (%1)
+        GROUP BY dxcc, grid, band_id, mode_id
+    )").arg(unionAcross(branch, QStringList("main") + archives)));
     
-    query.prepare("DELETE FROM contacts WHERE id = ?");
-    query.addBindValue(contactId);
-    
-    if (!query.exec()) {
-        m_lastError = "Errore eliminazione contatto: " + query.lastError().text();
-        return false;
+    while (query.next()) {
+        AwardSummary summary;
+        summary.dxcc = query.value(0).toString();
+        summary.grid = query.value(1).toString();
+        summary.band = dictionaryName(BandDictionary, query.value(2).toInt());
+        summary.mode = dictionaryName(ModeDictionary, query.value(3).toInt());
+        summary.count = query.value(4).toInt();
+        summaries.append(summary);
     }
     
-    return true;
+    query.finish();
+    detachSchemas(archives);
+    return summaries;
 }
 
-Contact Database::getContact(int contactId) const
+qint64 Database::changeWatermark() const
 {
     QSqlQuery query(m_db);
+    execQuery(query, "SELECT COALESCE(MAX(seq), 0) FROM change_journal");
     
-    query.prepare("SELECT * FROM contacts WHERE id = ?");
-    query.addBindValue(contactId);
-    
-    if (query.exec() && query.next()) {
-        Contact contact;
-        contact.setId(query.value("id").toInt());
-        contact.setDateTime(QDateTime::fromString(query.value("datetime").toString(), Qt::ISODate));
-        contact.setCallsign(query.value("callsign").toString());
-        contact.setBand(query.value("band").toString());
-        contact.setMode(query.value("mode").toString());
-        contact.setRstSent(query.value("rst_sent").toString());
-        contact.setRstReceived(query.value("rst_received").toString());
-        contact.setDxcc(query.value("dxcc").toString());
-        contact.setLocator(query.value("locator").toString());
-        contact.setOperatorCall(query.value("operator_call").toString());
-        return contact;
+    if (query.next()) {
+        return query.value(0).toLongLong();
     }
     
-    return Contact();
+    return 0;
 }
 
-QList<Contact> Database::getAllContacts() const
+qint64 Database::changeJournalFloor() const
 {
-    QList<Contact> contacts;
-    QSqlQuery query("SELECT * FROM contacts ORDER BY datetime DESC", m_db);
+    // Ultima sequenza non più presente nel registro (potata)
+    QSqlQuery query(m_db);
+    execQuery(query, "SELECT MIN(seq) FROM change_journal");
     
-    while (query.next()) {
-        Contact contact;
-        contact.setId(query.value("id").toInt());
-        contact.setDateTime(QDateTime::fromString(query.value("datetime").toString(), Qt::ISODate));
-        contact.setCallsign(query.value("callsign").toString());
-        contact.setBand(query.value("band").toString());
-        contact.setMode(query.value("mode").toString());
-        contact.setRstSent(query.value("rst_sent").toString());
-        contact.setRstReceived(query.value("rst_received").toString());
-        contact.setDxcc(query.value("dxcc").toString());
-        contact.setLocator(query.value("locator").toString());
-        contact.setOperatorCall(query.value("operator_call").toString());
-        contacts.append(contact);
+    if (query.next() && !query.value(0).isNull()) {
+        return query.value(0).toLongLong() - 1;
     }
     
-    return contacts;
+    return changeWatermark();
 }
 
-QList<Contact> Database::searchContacts(const QString &searchTerm) const
+QList<Database::ChangeEntry> Database::changesSince(qint64 sequence, int limit) const
 {
-    QList<Contact> contacts;
+    QList<ChangeEntry> entries;
     QSqlQuery query(m_db);
     
-    QString sql = R"(
-        SELECT * FROM contacts 
-        WHERE callsign LIKE ? OR band LIKE ? OR mode LIKE ? OR dxcc LIKE ?
-        ORDER BY datetime DESC
-    )";
-    
-    query.prepare(sql);
-    QString term = "%" + searchTerm + "%";
-    query.addBindValue(term);
-    query.addBindValue(term);
-    query.addBindValue(term);
-    query.addBindValue(term);
+    query.prepare("SELECT seq, contact_id, operation FROM change_journal WHERE seq > ? ORDER BY seq LIMIT ?");
+    query.addBindValue(sequence);
+    query.addBindValue(limit);
     
-    if (query.exec()) {
+    if (execQuery(query)) {
         while (query.next()) {
-            Contact contact;
-            contact.setId(query.value("id").toInt());
-            contact.setDateTime(QDateTime::fromString(query.value("datetime").toString(), Qt::ISODate));
-            contact.setCallsign(query.value("callsign").toString());
-            contact.setBand(query.value("band").toString());
-            contact.setMode(query.value("mode").toString());
-            contact.setRstSent(query.value("rst_sent").toString());
-            contact.setRstReceived(query.value("rst_received").toString());
-            contact.setDxcc(query.value("dxcc").toString());
-            contact.setLocator(query.value("locator").toString());
-            contact.setOperatorCall(query.value("operator_call").toString());
-            contacts.append(contact);
+            ChangeEntry entry;
+            entry.sequence = query.value(0).toLongLong();
+            entry.contactId = query.value(1).toInt();
+            entry.operation = static_cast<ChangeOperation>(query.value(2).toInt());
+            entries.append(entry);
         }
+    } else {
+        qWarning() << "Errore lettura registro modifiche:" << query.lastError().text();
     }
     
-    return contacts;
+    return entries;
+}
+
+Database::ContactChanges Database::getContactChangesSince(qint64 watermark) const
+{
+    ContactChanges changes;
+    QHash<int, bool> latestRemoved;
+    QList<int> changedIds;
+    
+    // Le voci successive al watermark letto qui restano per il prossimo refresh
+    changes.watermark = changeWatermark();
+    
+    // Watermark più vecchio del registro disponibile (primo caricamento o
+    // registro potato): serve una ricarica completa
+    if (watermark < 0 || watermark < changeJournalFloor()) {
+        changes.fullReloadRequired = true;
+    } else {
+        // Oltre una certa soglia (es. importazione ADIF) una ricarica completa
+        // costa meno di tante letture puntuali: non serve leggere oltre
+        const QList<ChangeEntry> entries = changesSince(watermark, MaxChangeLogEntries);
+        
+        // Conserva solo l'ultimo stato di ogni contatto, nell'ordine di modifica
+        for (const ChangeEntry &entry : entries) {
+            if (entry.sequence > changes.watermark) {
+                break;
+            }
+            if (!latestRemoved.contains(entry.contactId)) {
+                changedIds.append(entry.contactId);
+            }
+            latestRemoved.insert(entry.contactId, entry.operation == ContactRemoved);
+        }
+        
+        changes.fullReloadRequired = changedIds.size() > MaxIncrementalChanges
+            || entries.size() >= MaxChangeLogEntries;
+    }
+    
+    if (!changes.fullReloadRequired) {
+        for (int contactId : changedIds) {
+            if (latestRemoved.value(contactId)) {
+                changes.removedIds.append(contactId);
+                continue;
+            }
+            
+            Contact contact = getContact(contactId);
+            if (contact.id() >= 0) {
+                changes.upserted.append(contact);
+            } else {
+                changes.removedIds.append(contactId);
+            }
+        }
+    }
+    
+    return changes;
+}
+
+void Database::notifyContactsChanged()
+{
+    // Dentro addContacts() la notifica parte una volta sola, dopo il commit
+    if (m_batchDepth > 0) {
+        return;
+    }
+    
+    emit notifier()->contactsChanged(changeWatermark());
 }
 
 bool Database::setOperatorCall(const QString &operatorCall)
@@ -302,33 +2488,31 @@ bool Database::setOperatorCall(const QString &operatorCall)
     query.prepare("INSERT OR REPLACE INTO settings (key, value) VALUES ('operator_call', ?)");
     query.addBindValue(operatorCall);
     
-    if (!query.exec()) {
+    if (!execQuery(query)) {
         m_lastError = "Errore impostazione operatore: " + query.lastError().text();
         return false;
     }
     
+    cacheSettings({{"operator_call", operatorCall}});
     return true;
 }
 
 QString Database::getOperatorCall() const
 {
-    QSqlQuery query(m_db);
-    query.prepare("SELECT value FROM settings WHERE key = 'operator_call'");
-    
-    if (query.exec() && query.next()) {
-        return query.value(0).toString();
-    }
-    
-    return QString();
+    QMutexLocker locker(&m_settingsMutex);
+    loadSettingsCache();
+    return settingsCache().operatorData.callsign;
 }
 
 bool Database::setOperatorData(const QString &callsign, const QString &firstName, 
                               const QString &lastName, const QString &locator)
 {
     QSqlQuery query(m_db);
+    const QString previousLocator = getOperatorData().locator;
     
-    // Inizia transazione
+    // Inizia transazione: dati dell'operatore e distanze dei QSO insieme
     if (!m_db.transaction()) {
+        m_lastError = "Errore salvataggio dati operatore: " + m_db.lastError().text();
         return false;
     }
     
@@ -341,33 +2525,40 @@ bool Database::setOperatorData(const QString &callsign, const QString &firstName
         query.addBindValue(keys[i]);
         query.addBindValue(values[i]);
         
-        if (!query.exec()) {
+        if (!execQuery(query)) {
+            m_lastError = "Errore salvataggio dati operatore: " + query.lastError().text();
             m_db.rollback();
             return false;
         }
     }
     
-    return m_db.commit();
-}
-
-Database::OperatorData Database::getOperatorData() const
-{
-    OperatorData data;
-    QSqlQuery query(m_db);
+    // Le distanze precalcolate si riferiscono al locatore precedente: se il
+    // ricalcolo fallisce anche il nuovo locatore viene annullato
+    if (locator.trimmed().toUpper() != previousLocator.trimmed().toUpper()
+        && !writeOperatorDistances(locator)) {
+        m_db.rollback();
+        return false;
+    }
     
-    QStringList keys = {"operator_call", "operator_firstname", "operator_lastname", "operator_locator"};
-    QString *fields[] = {&data.callsign, &data.firstName, &data.lastName, &data.locator};
+    if (!m_db.commit()) {
+        m_lastError = "Errore salvataggio dati operatore: " + m_db.lastError().text();
+        m_db.rollback();
+        return false;
+    }
     
+    QList<QPair<QString, QString>> written;
     for (int i = 0; i < keys.size(); ++i) {
-        query.prepare("SELECT value FROM settings WHERE key = ?");
-        query.addBindValue(keys[i]);
-        
-        if (query.exec() && query.next()) {
-            *fields[i] = query.value(0).toString();
-        }
+        written.append({keys[i], values[i]});
     }
-    
-    return data;
+    cacheSettings(written);
+    return true;
+}
+
+Database::OperatorData Database::getOperatorData() const
+{
+    QMutexLocker locker(&m_settingsMutex);
+    loadSettingsCache();
+    return settingsCache().operatorData;
 }
 
 bool Database::setApiCredentials(const QString &qrzUsername, const QString &qrzPassword,
@@ -390,58 +2581,112 @@ bool Database::setApiCredentials(const QString &qrzUsername, const QString &qrzP
         query.addBindValue(keys[i]);
         query.addBindValue(values[i]);
         
-        if (!query.exec()) {
+        if (!execQuery(query)) {
             m_db.rollback();
             return false;
         }
     }
     
-    return m_db.commit();
+    if (!m_db.commit()) {
+        return false;
+    }
+    
+    QList<QPair<QString, QString>> written;
+    for (int i = 0; i < keys.size(); ++i) {
+        written.append({keys[i], values[i]});
+    }
+    cacheSettings(written);
+    return true;
 }
 
 Database::ApiCredentials Database::getApiCredentials() const
 {
-    ApiCredentials credentials;
-    QSqlQuery query(m_db);
-    
-    // Carica username QRZ
-    query.prepare("SELECT value FROM settings WHERE key = 'qrz_username'");
-    if (query.exec() && query.next()) {
-        credentials.qrzUsername = query.value(0).toString();
+    QMutexLocker locker(&m_settingsMutex);
+    loadSettingsCache();
+    return settingsCache().apiCredentials;
+}
+
+void Database::loadSettingsCache() const
+{
+    // Da chiamare con m_settingsMutex acquisito. Una sola lettura della
+    // tabella settings; da qui in poi i get* leggono solo la memoria
+    SettingsCache &cache = settingsCache();
+    if (cache.loaded) {
+        return;
     }
     
-    // Carica password QRZ
-    query.prepare("SELECT value FROM settings WHERE key = 'qrz_password'");
-    if (query.exec() && query.next()) {
-        credentials.qrzPassword = query.value(0).toString();
-    }
+    cache = SettingsCache();
     
-    // Carica API key Clublog
-    query.prepare("SELECT value FROM settings WHERE key = 'clublog_apikey'");
-    if (query.exec() && query.next()) {
-        credentials.clublogApiKey = query.value(0).toString();
+    QSqlQuery query(m_db);
+    execQuery(query, "SELECT key, value FROM settings");
+    while (query.next()) {
+        applySetting(cache, query.value(0).toString(), query.value(1).toString());
     }
     
-    // Carica flag abilitazione QRZ
-    query.prepare("SELECT value FROM settings WHERE key = 'enable_qrz'");
-    if (query.exec() && query.next()) {
-        credentials.enableQrz = query.value(0).toString() == "1";
+    // Se la lettura fallisce (es. database non ancora aperto) si riprova
+    // alla prossima richiesta invece di memorizzare valori vuoti
+    cache.loaded = query.isActive();
+}
+
+void Database::cacheSettings(const QList<QPair<QString, QString>> &values)
+{
+    // Write-through dopo il commit: la cache resta allineata alla tabella
+    QMutexLocker locker(&m_settingsMutex);
+    SettingsCache &cache = settingsCache();
+    if (!cache.loaded) {
+        return; // verrà caricata per intero alla prima lettura
     }
     
-    // Carica flag abilitazione Clublog
-    query.prepare("SELECT value FROM settings WHERE key = 'enable_clublog'");
-    if (query.exec() && query.next()) {
-        credentials.enableClublog = query.value(0).toString() == "1";
+    for (const auto &value : values) {
+        applySetting(cache, value.first, value.second);
+    }
+}
+
+Database::SettingsCache &Database::settingsCache() const
+{
+    // Da chiamare con m_settingsMutex acquisito: una cache per logbook
+    return m_settingsCaches[m_cacheKey];
+}
+
+void Database::applySetting(SettingsCache &cache, const QString &key, const QString &value)
+{
+    if (key == "operator_call") {
+        cache.operatorData.callsign = value;
+    } else if (key == "operator_firstname") {
+        cache.operatorData.firstName = value;
+    } else if (key == "operator_lastname") {
+        cache.operatorData.lastName = value;
+    } else if (key == "operator_locator") {
+        cache.operatorData.locator = value;
+    } else if (key == "qrz_username") {
+        cache.apiCredentials.qrzUsername = value;
+    } else if (key == "qrz_password") {
+        cache.apiCredentials.qrzPassword = value;
+    } else if (key == "clublog_apikey") {
+        cache.apiCredentials.clublogApiKey = value;
+    } else if (key == "enable_qrz") {
+        cache.apiCredentials.enableQrz = value == "1";
+    } else if (key == "enable_clublog") {
+        cache.apiCredentials.enableClublog = value == "1";
+    } else if (key == "theme_mode") {
+        bool ok;
+        int themeValue = value.toInt(&ok);
+        if (ok && themeValue >= 0 && themeValue <= 3) {
+            cache.themeMode = static_cast<ThemeMode>(themeValue);
+        } else {
+            cache.themeMode = SystemTheme;
+        }
     }
-    
-    return credentials;
 }
 
 int Database::getTotalContacts() const
 {
-    QSqlQuery query("SELECT COUNT(*) FROM contacts", m_db);
+    // Ogni contatto ha esattamente una banda: la somma dei contatori per
+    // banda è il totale, senza COUNT(*) sulla tabella contacts
+    QSqlQuery query(m_db);
+    execQuery(query, "SELECT COALESCE(SUM(count), 0) FROM stats_band");
     
-    if (query.exec() && query.next()) {
+    if (query.next()) {
         return query.value(0).toInt();
     }
     
@@ -450,49 +2695,165 @@ int Database::getTotalContacts() const
 
 QStringList Database::getUniqueBands() const
 {
-    QStringList bands;
-    QSqlQuery query("SELECT DISTINCT band FROM contacts ORDER BY band", m_db);
+    return getBandCounts().keys();
+}
+
+QStringList Database::getUniqueModes() const
+{
+    return getModeCounts().keys();
+}
+
+QStringList Database::getUniqueDXCC() const
+{
+    return getDxccCounts().keys();
+}
+
+QMap<QString, int> Database::getBandCounts() const
+{
+    return readCounter(statisticsCounters().at(0));
+}
+
+QMap<QString, int> Database::getModeCounts() const
+{
+    return readCounter(statisticsCounters().at(1));
+}
+
+QMap<QString, int> Database::getDxccCounts() const
+{
+    return readCounter(statisticsCounters().at(2));
+}
+
+QMap<QDate, int> Database::getDailyCounts(const QDate &from, const QDate &to) const
+{
+    QMap<QDate, int> counts;
+    const QDate epochDate(1970, 1, 1);
     
-    while (query.next()) {
-        bands.append(query.value(0).toString());
+    QSqlQuery query(m_db);
+    query.prepare("SELECT value, count FROM stats_day WHERE value >= ? AND value <= ?");
+    query.addBindValue(from.isValid() ? epochDate.daysTo(from) : 0);
+    query.addBindValue(to.isValid() ? epochDate.daysTo(to) : std::numeric_limits<qint64>::max());
+    
+    if (execQuery(query)) {
+        while (query.next()) {
+            counts.insert(epochDate.addDays(query.value(0).toLongLong()), query.value(1).toInt());
+        }
     }
     
-    return bands;
+    return counts;
 }
 
-QStringList Database::getUniqueModes() const
+QMap<QString, int> Database::readCounter(const StatisticsCounter &counter) const
 {
-    QStringList modes;
-    QSqlQuery query("SELECT DISTINCT mode FROM contacts ORDER BY mode", m_db);
+    QMap<QString, int> counts;
+    QSqlQuery query(m_db);
+    execQuery(query, QString("SELECT value, count FROM %1").arg(counter.table));
     
     while (query.next()) {
-        modes.append(query.value(0).toString());
+        const QString value = counter.dictionary == NoDictionary
+            ? query.value(0).toString()
+            : dictionaryName(counter.dictionary, query.value(0).toInt());
+        counts.insert(value, query.value(1).toInt());
     }
     
-    return modes;
+    return counts;
 }
 
-QStringList Database::getUniqueDXCC() const
+QMap<QString, int> Database::readCounterAcross(const StatisticsCounter &counter, const QStringList &schemas) const
 {
-    QStringList dxcc;
-    QSqlQuery query("SELECT DISTINCT dxcc FROM contacts WHERE dxcc IS NOT NULL AND dxcc != '' ORDER BY dxcc", m_db);
+    // Gli id dei dizionari sono propri di ogni file: i nomi si risolvono in
+    // SQL con il dizionario dello stesso schema, poi si somma per nome
+    QStringList parts;
+    for (const QString &schema : schemas) {
+        if (counter.dictionary == NoDictionary) {
+            parts.append(QString("SELECT value, count FROM %1.%2").arg(schema, counter.table));
+        } else {
+            parts.append(QString("SELECT d.name AS value, s.count AS count FROM %1.%2 s JOIN %1.%3 d ON d.id = s.value")
+                         .arg(schema, counter.table, dictionaryTable(counter.dictionary)));
+        }
+    }
+    
+    QMap<QString, int> counts;
+    QSqlQuery query(m_db);
+    execQuery(query, QString("SELECT value, SUM(count) FROM (%1) GROUP BY value").arg(parts.join(" UNION ALL ")));
     
     while (query.next()) {
-        dxcc.append(query.value(0).toString());
+        counts.insert(query.value(0).toString(), query.value(1).toInt());
+    }
+    
+    return counts;
+}
+
+bool Database::verifyStatistics(bool rebuildOnMismatch, QStringList *differences)
+{
+    // Confronta ogni contatore con il conteggio da scansione completa
+    QStringList found;
+    QSqlQuery query(m_db);
+    
+    for (const StatisticsCounter &counter : statisticsCounters()) {
+        const QString table = counter.table;
+        const QString key = QString(counter.keyExpression).arg("contacts_data");
+        const QString condition = QString(counter.condition).arg("contacts_data");
+        
+        // Differenze in entrambe le direzioni: valori mancanti, in più o con conteggio diverso
+        QString sql = QString(R"(
+            WITH scan(value, count) AS (
+                SELECT %2, COUNT(*) FROM contacts_data WHERE %3 GROUP BY 1
+            )
+            SELECT scan.value, scan.count, %1.count FROM scan
+            LEFT JOIN %1 ON %1.value = scan.value
+            WHERE %1.count IS NULL OR %1.count != scan.count
+            UNION ALL
+            SELECT %1.value, NULL, %1.count FROM %1
+            WHERE %1.value NOT IN (SELECT value FROM scan)
+        )").arg(table, key, condition);
+        
+        if (!execQuery(query, sql)) {
+            m_lastError = "Errore verifica " + table + ": " + query.lastError().text();
+            return false;
+        }
+        
+        while (query.next()) {
+            found.append(QString("%1[%2]: atteso %3, contatore %4")
+                .arg(table, query.value(0).toString(),
+                     QString::number(query.value(1).toInt()), QString::number(query.value(2).toInt())));
+        }
     }
     
-    return dxcc;
+    if (differences) {
+        *differences = found;
+    }
+    
+    if (found.isEmpty()) {
+        return true;
+    }
+    
+    qWarning() << "Statistiche non allineate:" << found;
+    
+    if (rebuildOnMismatch) {
+        const bool inTransaction = m_db.transaction();
+        if (fillStatisticsTables()) {
+            if (inTransaction) {
+                m_db.commit();
+            }
+        } else if (inTransaction) {
+            m_db.rollback();
+        }
+    }
+    
+    return false;
 }
 
 bool Database::clearAllSettings()
 {
     QSqlQuery query(m_db);
     
-    if (!query.exec("DELETE FROM settings")) {
+    if (!execQuery(query, "DELETE FROM settings")) {
         m_lastError = "Errore durante il reset delle impostazioni: " + query.lastError().text();
         return false;
     }
     
+    QMutexLocker locker(&m_settingsMutex);
+    settingsCache() = SettingsCache();
     return true;
 }
 
@@ -500,44 +2861,38 @@ bool Database::clearAllContacts()
 {
     QSqlQuery query(m_db);
     
-    if (!query.exec("DELETE FROM contacts")) {
+    if (!execQuery(query, "DELETE FROM contacts_data")) {
         m_lastError = "Errore durante la cancellazione dei contatti: " + query.lastError().text();
         return false;
     }
     
+    notifyContactsChanged();
     return true;
 }
 
 bool Database::setThemeSettings(ThemeMode themeMode)
 {
     QSqlQuery query(m_db);
+    const QString value = QString::number(static_cast<int>(themeMode));
     
     query.prepare("INSERT OR REPLACE INTO settings (key, value) VALUES ('theme_mode', ?)");
-    query.addBindValue(QString::number(static_cast<int>(themeMode)));
+    query.addBindValue(value);
     
-    if (!query.exec()) {
+    if (!execQuery(query)) {
         m_lastError = "Errore impostazione tema: " + query.lastError().text();
         return false;
     }
     
+    cacheSettings({{"theme_mode", value}});
     return true;
 }
 
 Database::ThemeMode Database::getThemeSettings() const
 {
-    QSqlQuery query(m_db);
-    query.prepare("SELECT value FROM settings WHERE key = 'theme_mode'");
-    
-    if (query.exec() && query.next()) {
-        bool ok;
-        int themeValue = query.value(0).toInt(&ok);
-        if (ok && themeValue >= 0 && themeValue <= 3) {
-            return static_cast<ThemeMode>(themeValue);
-        }
-    }
-    
-    // Default: usa il tema di sistema
-    return SystemTheme;
+    // Default (nessun valore salvato): usa il tema di sistema
+    QMutexLocker locker(&m_settingsMutex);
+    loadSettingsCache();
+    return settingsCache().themeMode;
 }
 
 QString Database::lastError() const
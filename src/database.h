@@ -6,26 +6,249 @@
 #include <QtSql/QSqlError>
 #include <QtCore/QString>
 #include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QMap>
+#include <QtCore/QPair>
+#include <QtCore/QHash>
+#include <QtCore/QDate>
+#include <QtCore/QObject>
 
 #include "contact.h"
+#include "compactcontact.h"
+#include "contactquery.h"
+#include "maidenhead.h"
+
+// Notifica le modifiche ai contatti fatte da qualsiasi connessione del
+// processo; sequence è il watermark da passare a changesSince()
+class DatabaseNotifier : public QObject
+{
+    Q_OBJECT
+
+public:
+    using QObject::QObject;
+
+signals:
+    void contactsChanged(qint64 sequence);
+};
 
 class Database
 {
 public:
+    static constexpr int SchemaVersion = 7;           // PRAGMA user_version
+    static constexpr int EpochBackfillBatchSize = 2000;
+    static constexpr int VacuumPagesPerStep = 256;    // 1 MB con pagine da 4 KB
+    static constexpr int AnalysisLimit = 1000;        // righe per indice lette da ANALYZE
+    static constexpr double StatisticsDriftThreshold = 0.2;
+    static constexpr double NearestSearchStartKm = 100.0;   // raggio iniziale di nearestContacts()
+    
     static Database* instance();
     static void destroy();
+    static DatabaseNotifier *notifier();
+    
+    // Più logbook (uno per nominativo o evento), ciascuno nel proprio file.
+    // instance() è il logbook attivo; gli altri già aperti restano in cache
+    // con la propria connessione: il passaggio non riapre né migra il file
+    static QString defaultLogbookPath();
+    static QString lastLogbookPath();           // ultimo attivo, altrimenti il predefinito
+    static QStringList knownLogbooks();         // logbook usati, dal più recente
+    static QString logbookName(const QString &path);
+    static Database *openLogbook(const QString &path, QString *errorMessage = nullptr);
+    static bool switchLogbook(const QString &path, QString *errorMessage = nullptr);
+    static void closeLogbook(const QString &path);
     
     bool initialize(const QString &dbPath = QString());
+    bool initializeReadOnly(const QString &dbPath);
     bool isOpen() const;
     void close();
+    QString databasePath() const;
+    
+    // Sostituisce il file con un backup (DatabaseBackup) e riapre la
+    // connessione. Le altre connessioni allo stesso file vanno chiuse prima;
+    // nessuna notifica: il chiamante ricarica da zero i contatti
+    bool restoreFromBackup(const QString &backupPath);
+    
+    // Schema versioning
+    int schemaVersion() const;
+    // Conversione a lotti delle date esistenti nella colonna epoch intera;
+    // restituisce le righe convertite (0 = terminato, -1 = errore)
+    int backfillEpochBatch(int batchSize = EpochBackfillBatchSize);
+    
+    // Manutenzione dello spazio: dalla versione 6 il file usa auto_vacuum
+    // incrementale, le pagine liberate da cancellazioni e archiviazioni
+    // restano nella freelist finché non vengono restituite a piccoli passi
+    enum AutoVacuumMode {
+        NoAutoVacuum = 0,
+        FullAutoVacuum = 1,
+        IncrementalAutoVacuum = 2
+    };
+    struct StorageStatistics {
+        int pageSize = 0;
+        qint64 pageCount = 0;
+        qint64 freelistCount = 0;       // pagine libere recuperabili
+        AutoVacuumMode autoVacuum = NoAutoVacuum;
+        double fragmentation = -1.0;    // pagine di contacts_data fuori sequenza, -1 = non misurata
+        qint64 analyzedRows = -1;       // righe secondo sqlite_stat1, -1 = mai analizzato
+        qint64 currentRows = 0;
+        
+        double freelistRatio() const
+        {
+            return pageCount > 0 ? double(freelistCount) / double(pageCount) : 0.0;
+        }
+        // Scostamento relativo tra righe attuali e righe viste dall'ultimo ANALYZE
+        double statisticsDrift() const;
+    };
+    AutoVacuumMode autoVacuumMode() const;
+    // La frammentazione richiede una scansione di contacts_data (dbstat)
+    StorageStatistics storageStatistics(bool measureFragmentation = false) const;
+    // Restituisce alla freelist del file system fino a maxPages pagine;
+    // restituisce le pagine liberate (0 = freelist vuota, -1 = errore)
+    int incrementalVacuumStep(int maxPages = VacuumPagesPerStep);
+    // ANALYZE se le statistiche dell'ottimizzatore si sono allontanate dai
+    // dati, altrimenti PRAGMA optimize (di norma nessuna operazione)
+    bool refreshQueryStatistics(bool *analyzed = nullptr);
+    bool checkpointWal();
     
     // Contact operations
     bool addContact(Contact &contact);
+    int addContacts(QList<Contact> &contacts, const QString &importSource = QString());
     bool updateContact(const Contact &contact);
     bool deleteContact(int contactId);
+    
+    // Bulk operations: una transazione e una notifica per operazione
+    enum ContactField {
+        CallsignField,
+        BandField,
+        ModeField,
+        RstSentField,
+        RstReceivedField,
+        DxccField,
+        LocatorField,
+        OperatorField
+    };
+    struct ImportBatch {
+        qint64 id = 0;
+        QString source;         // es. percorso del file ADIF
+        QDateTime createdAt;
+        int contactCount = 0;
+    };
+    bool deleteContacts(const QList<int> &contactIds);
+    bool updateField(const QList<int> &contactIds, ContactField field, const QString &value);
+    bool deleteImportBatch(qint64 importBatch);
+    QList<ImportBatch> getImportBatches() const;
     Contact getContact(int contactId) const;
-    QList<Contact> getAllContacts() const;
-    QList<Contact> searchContacts(const QString &searchTerm) const;
+    QList<Contact> getAllContacts(bool includeArchives = false) const;
+    QList<CompactContact> getAllCompactContacts() const;
+    QList<Contact> searchContacts(const QString &searchTerm, bool includeArchives = false) const;
+    
+    // Filtered queries
+    ContactCursor openContactCursor(const ContactQuery &query) const;
+    QList<Contact> queryContacts(const ContactQuery &query) const;
+    QStringList explainContactQuery(const ContactQuery &query) const;
+    // true se il piano non contiene scansioni complete di contacts
+    bool verifyContactQueryPlan(const ContactQuery &query, QStringList *plan = nullptr) const;
+    // Verifica i piani delle forme di ContactQuery usate dall'applicazione
+    // (--verify-query-plans); report riceve una riga per query più il piano
+    bool verifyContactQueryPlans(QStringList *report = nullptr) const;
+    
+    // Query tra logbook: gli altri file vengono collegati in sola lettura
+    // (ATTACH) per la durata della query, senza copiarne i dati. Il logbook
+    // corrente è sempre incluso; la ricerca di un nominativo comprende anche
+    // gli archivi annuali di ogni logbook
+    struct WorkedEntry {
+        QString logbook;        // logbookName() del file
+        QString band;
+        QString mode;
+        int count = 0;
+        qint64 lastEpoch = 0;
+    };
+    struct LogbookStatistics {
+        int totalContacts = 0;
+        QMap<QString, int> bandCounts;
+        QMap<QString, int> modeCounts;
+        QMap<QString, int> dxccCounts;
+    };
+    QList<WorkedEntry> workedBeforeAcrossLogbooks(const QString &callsign, const QStringList &logbookPaths) const;
+    LogbookStatistics getStatisticsAcrossLogbooks(const QStringList &logbookPaths) const;
+    
+    // Query geografiche: latitudine e longitudine del locatore (centro del
+    // quadrato) vengono calcolate all'inserimento e indicizzate nell'R*Tree
+    // contacts_geo; distance_km è la distanza dal locatore dell'operatore.
+    // Solo il database principale, come le statistiche
+    struct LocatedContact {
+        Contact contact;
+        double latitude = 0.0;
+        double longitude = 0.0;
+        double distanceKm = -1.0;   // dal punto della query, altrimenti dall'operatore
+    };
+    // minLongitude > maxLongitude: rettangolo a cavallo dell'antimeridiano
+    QList<LocatedContact> contactsInBoundingBox(double minLatitude, double maxLatitude,
+                                                double minLongitude, double maxLongitude) const;
+    QList<LocatedContact> contactsWithinRadius(double latitude, double longitude, double radiusKm) const;
+    QList<LocatedContact> nearestContacts(double latitude, double longitude, int limit) const;
+    QList<LocatedContact> contactsBeyondDistance(double minDistanceKm) const;
+    // Quadrati (4 caratteri) lavorati entro il raggio
+    QStringList gridsWithinRadius(double latitude, double longitude, double radiusKm) const;
+    // Ricalcola distance_km di tutti i QSO (cambio del locatore operatore)
+    bool refreshOperatorDistances();
+    
+    // Archivio annuale: i QSO precedenti all'anno di taglio passano in un file
+    // per anno (archive/logbook_AAAA.db accanto al database) e lasciano il
+    // database principale, statistiche comprese. Ogni chiamata che li chiede
+    // (includeArchives, ContactQuery con archivi o con un intervallo di tempo
+    // che ne copre gli anni) li collega in sola lettura (ATTACH), unisce
+    // database principale e archivi e li scollega al termine. Duplicati e
+    // diplomi li includono sempre
+    QString archiveDirectory() const { return archiveDirectory(databasePath()); }
+    QString archivePath(int year) const { return archivePath(databasePath(), year); }
+    QList<int> archiveYears() const { return archiveYears(databasePath()); }
+    // Stessi percorsi per un logbook qualsiasi, anche non aperto
+    static QString archiveDirectory(const QString &logbookPath);
+    static QString archivePath(const QString &logbookPath, int year);
+    static QList<int> archiveYears(const QString &logbookPath);
+    int archiveContactsBefore(int cutoffYear);  // QSO spostati, -1 = errore
+    
+    // Duplicate checking
+    struct DupeSummary {
+        QString callsign;
+        QString band;
+        QString mode;
+        qint64 firstEpoch = 0;  // primo e ultimo QSO per nominativo/banda/modo
+        qint64 lastEpoch = 0;
+    };
+    QList<Contact> findDuplicates(const Contact &contact, qint64 windowSeconds) const;
+    QList<DupeSummary> getDupeSummaries() const;
+    
+    // Conteggi per DXCC, quadrato del locatore, banda e modo (diplomi)
+    struct AwardSummary {
+        QString dxcc;
+        QString grid;           // primi 4 caratteri del locatore
+        QString band;
+        QString mode;
+        int count = 0;
+    };
+    QList<AwardSummary> getAwardSummaries() const;
+    
+    // Incremental refresh
+    struct ContactChanges {
+        QList<Contact> upserted;    // contatti inseriti o modificati
+        QList<int> removedIds;      // contatti eliminati
+        qint64 watermark = 0;       // da passare alla richiesta successiva
+        bool fullReloadRequired = false;
+    };
+    enum ChangeOperation {
+        ContactInserted = 0,
+        ContactUpdated = 1,
+        ContactRemoved = 2
+    };
+    struct ChangeEntry {
+        qint64 sequence = 0;
+        int contactId = -1;
+        ChangeOperation operation = ContactUpdated;
+    };
+    qint64 changeWatermark() const;
+    qint64 changeJournalFloor() const;
+    QList<ChangeEntry> changesSince(qint64 sequence, int limit = -1) const;
+    ContactChanges getContactChangesSince(qint64 watermark) const;
     
     // Operator management
     bool setOperatorCall(const QString &operatorCall);
@@ -69,15 +292,26 @@ public:
     QStringList getUniqueBands() const;
     QStringList getUniqueModes() const;
     QStringList getUniqueDXCC() const;
+    QMap<QString, int> getBandCounts() const;
+    QMap<QString, int> getModeCounts() const;
+    QMap<QString, int> getDxccCounts() const;
+    QMap<QDate, int> getDailyCounts(const QDate &from = QDate(), const QDate &to = QDate()) const;
+    // Confronta i contatori con una scansione completa; se richiesto li
+    // ricostruisce. Restituisce true se erano già allineati
+    bool verifyStatistics(bool rebuildOnMismatch = true, QStringList *differences = nullptr);
     
     // Settings management
     bool clearAllSettings();
     bool clearAllContacts();
     
     QString lastError() const;
-    
+
 private:
-    Database();
+    friend class AsyncDatabase;
+    friend class DatabaseReadPool;
+    friend class ContactCursor;
+    
+    explicit Database(const QString &connectionName = QString());
     ~Database();
     Database(const Database&) = delete;
     Database& operator=(const Database&) = delete;
@@ -85,10 +319,121 @@ private:
     bool createTables();
     bool createContactsTable();
     bool createSettingsTable();
+    bool migrateSchema();
+    bool migrateToEpochColumn();
+    bool migrateToDictionaryTables();
+    bool migrateToStatisticsTables();
+    bool migrateToChangeJournal();
+    bool migrateToImportBatches();
+    bool migrateToGeoIndex();
+    bool archiveYear(int year, qint64 toEpoch, int *moved);
+    QList<int> archiveYearsFor(const ContactQuery &contactQuery) const;
+    QStringList attachArchives(const QList<int> &years) const;  // schemi collegati
+    // attachedCount: database già collegati dal chiamante, per il limite di SQLite
+    QStringList attachLogbooks(const QStringList &logbookPaths, QStringList *names,
+                               bool includeArchives = false, int attachedCount = 0) const;
+    void detachSchemas(const QStringList &schemas) const;
+    static void rememberLogbook(const QString &path);
+    // contacts, o l'unione con gli archivi collegati
+    static QString contactSource(const QStringList &archiveSchemas);
+    // Unione di un ramo per schema: %1 nel ramo è il nome dello schema
+    static QString unionAcross(const QString &branch, const QStringList &schemas);
+    static qint64 yearStartEpoch(int year);
+    QVariantList geoValues(const QString &locator) const;
+    LocatedContact locatedContactFromQuery(const QSqlQuery &query) const;
+    QList<LocatedContact> queryBoundingBoxes(const QList<Maidenhead::BoundingBox> &boxes) const;
+    // distance_km rispetto al locatore, nella transazione del chiamante
+    bool writeOperatorDistances(const QString &locator);
+    bool runChunked(const QList<int> &contactIds, const QString &sqlTemplate,
+                    const QVariantList &leadingValues, const QString &errorPrefix);
+    bool fillStatisticsTables();
+    
+    // Tutte le query passano da qui: tempi per istruzione in QueryProfiler e,
+    // oltre la soglia, registro con forma dei parametri e piano di esecuzione
+    bool execQuery(QSqlQuery &query, const QString &sql = QString()) const;
+    QStringList explainStatement(const QString &sql, const QVariantList &bindValues) const;
+    
+    // Dizionari band/mode/operatore: id interi in contacts_data, nomi in cache
+    enum Dictionary {
+        BandDictionary = 0,
+        ModeDictionary,
+        OperatorDictionary,
+        DictionaryCount,
+        NoDictionary = DictionaryCount
+    };
+    static const char *dictionaryTable(Dictionary dictionary);
+    int dictionaryId(Dictionary dictionary, const QString &name);
+    int lookupDictionaryId(Dictionary dictionary, const QString &name) const;
+    QString dictionaryName(Dictionary dictionary, int id) const;
+    void loadDictionary(Dictionary dictionary) const;
+    void invalidateDictionaryCache() const;
+    
+    Contact contactFromQuery(const QSqlQuery &query) const;
+    void notifyContactsChanged();
+    void loadSettingsCache() const;
+    void cacheSettings(const QList<QPair<QString, QString>> &values);
+    
+    struct StatisticsCounter {
+        const char *table;
+        const char *keyType;
+        const char *keyExpression;
+        const char *condition;
+        Dictionary dictionary;
+    };
+    static QList<StatisticsCounter> statisticsCounters();
+    QMap<QString, int> readCounter(const StatisticsCounter &counter) const;
+    QMap<QString, int> readCounterAcross(const StatisticsCounter &counter, const QStringList &schemas) const;
+    
+    static constexpr int MaxChangeLogEntries = 10000;
+    static constexpr int MaxIncrementalChanges = 500;
+    static constexpr int MaxIdsPerStatement = 500;  // sotto il limite di parametri SQLite
+    static constexpr int MaxAttachedDatabases = 9;  // SQLITE_MAX_ATTACHED è 10 (temp escluso)
+    static constexpr int MaxRecentLogbooks = 10;
+    
+    // Colonne degli archivi: contacts_data e la vista contacts dello schema 5.
+    // Le unioni elencano le colonne, così le migrazioni successive del
+    // database principale non rompono gli archivi già scritti
+    static constexpr const char *ArchiveTableColumns =
+        "id, datetime, datetime_utc, callsign, band_id, mode_id, rst_sent, rst_received, "
+        "dxcc, locator, operator_id, import_batch, created_at";
+    static constexpr const char *ArchiveViewColumns =
+        "id, datetime, datetime_utc, callsign, band_id, band, mode_id, mode, rst_sent, rst_received, "
+        "dxcc, locator, operator_id, operator_call, import_batch, created_at";
     
     static Database* m_instance;
+    static QHash<QString, Database*> m_logbooks;    // logbook aperti non attivi, per percorso
     QSqlDatabase m_db;
+    QString m_cacheKey;     // percorso assoluto del file: chiave delle cache condivise
     QString m_lastError;
+    int m_batchDepth = 0;   // > 0 durante addContacts(): notifiche sospese
+    qint64 m_importBatch = 0;   // lotto assegnato ai contatti inseriti da addContacts()
+    mutable int m_archiveSerial = 0;    // nomi unici per gli archivi collegati
+    
+    // Copia tipizzata della tabella settings, caricata una volta e aggiornata
+    // in write-through dai set*; condivisa dalle connessioni allo stesso file
+    struct SettingsCache {
+        bool loaded = false;
+        OperatorData operatorData;
+        ApiCredentials apiCredentials {QString(), QString(), QString(), false, false};
+        ThemeMode themeMode = SystemTheme;
+    };
+    static QHash<QString, SettingsCache> m_settingsCaches;     // per percorso del file
+    static QMutex m_settingsMutex;
+    SettingsCache &settingsCache() const;
+    static void applySetting(SettingsCache &cache, const QString &key, const QString &value);
+    
+    // Cache id <-> nome dei dizionari, condivisa dalle connessioni allo stesso file
+    struct DictionaryCache {
+        bool loaded = false;
+        QHash<QString, int> ids;
+        QHash<int, QString> names;
+    };
+    struct DictionarySet {
+        DictionaryCache dictionaries[DictionaryCount];
+    };
+    static QHash<QString, DictionarySet> m_dictionaryCaches;  // per percorso del file
+    static QMutex m_dictionaryMutex;
+    DictionaryCache &dictionaryCache(Dictionary dictionary) const;
 };
 
 #endif // DATABASE_H
\ No newline at end of file
@@ -0,0 +1,313 @@
+#include "databasebackup.h"
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QDir>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QDebug>
+#include <sqlite3.h>
+
+DatabaseBackup::DatabaseBackup(const QString &databasePath, QObject *parent)
+    : QObject(parent)
+    , m_databasePath(databasePath)
+    , m_thread(nullptr)
+    , m_cancelled(false)
+{
+}
+
+DatabaseBackup::~DatabaseBackup()
+{
+    // Un backup interrotto non lascia file: la copia parziale viene rimossa
+    cancel();
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+bool DatabaseBackup::start(const QString &destinationPath)
+{
+    if (isRunning()) {
+        return false;
+    }
+    
+    delete m_thread;
+    m_destinationPath = destinationPath;
+    m_cancelled = false;
+    
+    m_thread = QThread::create([this, destinationPath]() {
+        QString errorMessage;
+        const bool success = backup(m_databasePath, destinationPath, [this](int copiedPages, int totalPages) {
+            emit progress(copiedPages, totalPages);
+            return !m_cancelled.load();
+        }, &errorMessage);
+        emit finished(success, errorMessage);
+    });
+    m_thread->setObjectName("DatabaseBackupThread");
+    m_thread->start(QThread::LowPriority);
+    
+    return true;
+}
+
+void DatabaseBackup::cancel()
+{
+    m_cancelled = true;
+}
+
+bool DatabaseBackup::isRunning() const
+{
+    return m_thread && m_thread->isRunning();
+}
+
+QString DatabaseBackup::errorText(int resultCode, const char *message)
+{
+    return QString("%1 (codice SQLite %2)").arg(QString::fromUtf8(message)).arg(resultCode);
+}
+
+bool DatabaseBackup::backup(const QString &sourcePath, const QString &destinationPath,
+                            const std::function<bool(int, int)> &progress, QString *errorMessage)
+{
+    const QString partialPath = destinationPath + ".part";
+    QFile::remove(partialPath);
+    
+    sqlite3 *source = nullptr;
+    sqlite3 *destination = nullptr;
+    QString error;
+    
+    int rc = sqlite3_open_v2(sourcePath.toUtf8().constData(), &source, SQLITE_OPEN_READONLY, nullptr);
+    if (rc != SQLITE_OK) {
+        error = "Impossibile aprire il database: " + errorText(rc, sqlite3_errmsg(source));
+    } else {
+        sqlite3_busy_timeout(source, 5000);
+        rc = sqlite3_open_v2(partialPath.toUtf8().constData(), &destination,
+                             SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
+        if (rc != SQLITE_OK) {
+            error = "Impossibile creare il file di backup: " + errorText(rc, sqlite3_errmsg(destination));
+        }
+    }
+    
+    if (error.isEmpty()) {
+        sqlite3_backup *handle = sqlite3_backup_init(destination, "main", source, "main");
+        if (!handle) {
+            rc = sqlite3_errcode(destination);
+            error = "Impossibile avviare il backup: " + errorText(rc, sqlite3_errmsg(destination));
+        } else {
+            // Copia a passi di PagesPerStep dentro una transazione di lettura
+            // aperta sulla connessione sorgente: ogni passo legge la stessa
+            // istantanea, quindi le scritture delle altre connessioni (in WAL
+            // non bloccate) non fanno ripartire la copia dalla prima pagina.
+            // Tra un passo e l'altro si aggiornano avanzamento e annullamento
+            bool cancelled = false;
+            rc = sqlite3_exec(source, "BEGIN; SELECT COUNT(*) FROM sqlite_master;", nullptr, nullptr, nullptr);
+            while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+                if (rc != SQLITE_OK) {
+                    sqlite3_sleep(BusyRetryMillis);
+                }
+                rc = sqlite3_backup_step(handle, PagesPerStep);
+                if (rc == SQLITE_DONE) {
+                    break;
+                }
+                const int totalPages = sqlite3_backup_pagecount(handle);
+                if (progress && !progress(totalPages - sqlite3_backup_remaining(handle), totalPages)) {
+                    cancelled = true;
+                    break;
+                }
+            }
+            sqlite3_exec(source, "COMMIT", nullptr, nullptr, nullptr);
+            
+            if (!cancelled && rc == SQLITE_DONE && progress) {
+                const int totalPages = sqlite3_backup_pagecount(handle);
+                progress(totalPages, totalPages);
+            }
+            
+            sqlite3_backup_finish(handle);
+            
+            if (cancelled) {
+                error = "Backup annullato";
+            } else if (rc != SQLITE_DONE) {
+                error = "Errore durante il backup: " + errorText(rc, sqlite3_errstr(rc));
+            } else {
+                // La copia eredita la modalità WAL dell'originale: il backup deve
+                // essere un file unico, senza -wal/-shm accanto
+                sqlite3_exec(destination, "PRAGMA journal_mode = DELETE", nullptr, nullptr, nullptr);
+            }
+        }
+    }
+    
+    sqlite3_close(destination);
+    sqlite3_close(source);
+    
+    if (error.isEmpty()) {
+        QFile::remove(destinationPath);
+        if (!QFile::rename(partialPath, destinationPath)) {
+            error = "Impossibile salvare il file di backup: " + destinationPath;
+        }
+    }
+    
+    if (!error.isEmpty()) {
+        QFile::remove(partialPath);
+        if (errorMessage) {
+            *errorMessage = error;
+        }
+        return false;
+    }
+    
+    return true;
+}
+
+bool DatabaseBackup::verify(const QString &backupPath, QString *errorMessage)
+{
+    sqlite3 *database = nullptr;
+    QString error;
+    
+    int rc = sqlite3_open_v2(backupPath.toUtf8().constData(), &database, SQLITE_OPEN_READONLY, nullptr);
+    if (rc != SQLITE_OK) {
+        error = "Impossibile aprire il backup: " + errorText(rc, sqlite3_errmsg(database));
+    } else {
+        // quick_check controlla la struttura delle pagine senza confrontare gli
+        // indici con le tabelle: pochi istanti anche su logbook grandi
+        sqlite3_stmt *statement = nullptr;
+        rc = sqlite3_prepare_v2(database, "PRAGMA quick_check", -1, &statement, nullptr);
+        if (rc != SQLITE_OK) {
+            error = "Il file non è un database valido: " + errorText(rc, sqlite3_errmsg(database));
+        } else if (sqlite3_step(statement) != SQLITE_ROW
+                   || qstrcmp(reinterpret_cast<const char *>(sqlite3_column_text(statement, 0)), "ok") != 0) {
+            error = "Il backup è danneggiato";
+        }
+        sqlite3_finalize(statement);
+        
+        if (error.isEmpty()) {
+            rc = sqlite3_prepare_v2(database,
+                "SELECT COUNT(*) FROM sqlite_master WHERE name IN ('contacts', 'settings')",
+                -1, &statement, nullptr);
+            if (rc != SQLITE_OK || sqlite3_step(statement) != SQLITE_ROW
+                || sqlite3_column_int(statement, 0) != 2) {
+                error = "Il file non è un backup del logbook";
+            }
+            sqlite3_finalize(statement);
+        }
+    }
+    
+    sqlite3_close(database);
+    
+    if (!error.isEmpty()) {
+        if (errorMessage) {
+            *errorMessage = error;
+        }
+        return false;
+    }
+    
+    return true;
+}
+
+bool DatabaseBackup::restore(const QString &backupPath, const QString &databasePath, QString *errorMessage)
+{
+    if (!verify(backupPath, errorMessage)) {
+        return false;
+    }
+    
+    // Il backup viene prima copiato accanto al database, poi i file vengono
+    // scambiati con due rinomine: nessuna reimportazione dei contatti
+    const QString incomingPath = databasePath + ".restore";
+    const QString asidePath = databasePath + ".before-restore";
+    
+    QFile::remove(incomingPath);
+    if (!QFile::copy(backupPath, incomingPath)) {
+        if (errorMessage) {
+            *errorMessage = "Impossibile copiare il backup in " + incomingPath;
+        }
+        return false;
+    }
+    
+    // Il file -wal eventualmente rimasto appartiene al database corrente e
+    // lo segue; il -shm viene ricreato da SQLite all'apertura
+    const QStringList suffixes = {QString(), QString("-wal")};
+    for (const QString &suffix : suffixes) {
+        QFile::remove(asidePath + suffix);
+    }
+    QFile::remove(databasePath + "-shm");
+    
+    for (const QString &suffix : suffixes) {
+        if (QFile::exists(databasePath + suffix) && !QFile::rename(databasePath + suffix, asidePath + suffix)) {
+            // Ripristina quanto già spostato
+            for (const QString &moved : suffixes) {
+                if (QFile::exists(asidePath + moved)) {
+                    QFile::rename(asidePath + moved, databasePath + moved);
+                }
+            }
+            QFile::remove(incomingPath);
+            if (errorMessage) {
+                *errorMessage = "Impossibile spostare il database corrente: " + databasePath + suffix;
+            }
+            return false;
+        }
+    }
+    
+    if (!QFile::rename(incomingPath, databasePath)) {
+        for (const QString &suffix : suffixes) {
+            if (QFile::exists(asidePath + suffix)) {
+                QFile::rename(asidePath + suffix, databasePath + suffix);
+            }
+        }
+        QFile::remove(incomingPath);
+        if (errorMessage) {
+            *errorMessage = "Impossibile sostituire il database con il backup";
+        }
+        return false;
+    }
+    
+    return true;
+}
+
+QString DatabaseBackup::backupDirectory()
+{
+    QString path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/backups";
+    QDir().mkpath(path);
+    return path;
+}
+
+QString DatabaseBackup::rotatingBackupPath(const QString &databasePath)
+{
+    return backupDirectory() + QString("/%1_%2.db")
+        .arg(QFileInfo(databasePath).completeBaseName(),
+             QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
+}
+
+QStringList DatabaseBackup::rotatingBackups(const QString &databasePath)
+{
+    // Il timestamp nel nome rende l'ordine alfabetico cronologico
+    QDir directory(backupDirectory());
+    const QString pattern = QFileInfo(databasePath).completeBaseName() + "_????????_??????.db";
+    const QStringList names = directory.entryList(QStringList() << pattern, QDir::Files,
+                                                  QDir::Name | QDir::Reversed);
+    
+    QStringList paths;
+    for (const QString &name : names) {
+        paths.append(directory.absoluteFilePath(name));
+    }
+    return paths;
+}
+
+QDateTime DatabaseBackup::lastRotatingBackupTime(const QString &databasePath)
+{
+    const QStringList backups = rotatingBackups(databasePath);
+    if (backups.isEmpty()) {
+        return QDateTime();
+    }
+    return QFileInfo(backups.first()).lastModified();
+}
+
+int DatabaseBackup::pruneRotatingBackups(const QString &databasePath, int keepCount)
+{
+    const QStringList backups = rotatingBackups(databasePath);
+    int removed = 0;
+    
+    for (int i = qMax(keepCount, 1); i < backups.size(); ++i) {
+        if (QFile::remove(backups.at(i))) {
+            removed++;
+        } else {
+            qWarning() << "Impossibile rimuovere il vecchio backup:" << backups.at(i);
+        }
+    }
+    
+    return removed;
+}
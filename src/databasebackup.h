@@ -0,0 +1,73 @@
+#ifndef DATABASEBACKUP_H
+#define DATABASEBACKUP_H
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QDateTime>
+#include <QtCore/QThread>
+#include <atomic>
+#include <functional>
+
+// Backup nativo del logbook con l'API di backup online di SQLite
+// (sqlite3_backup_*). Il file viene copiato a passi su due connessioni
+// proprie, tutti dentro la stessa transazione di lettura: con il journal WAL
+// le scritture dell'applicazione proseguono durante la copia, che resta
+// l'istantanea dell'inizio e può essere annullata tra un passo e l'altro.
+// La copia comprende tutte le tabelle, impostazioni incluse.
+class DatabaseBackup : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int PagesPerStep = 256;        // pagine per sqlite3_backup_step
+    static constexpr int BusyRetryMillis = 100;     // attesa con il database occupato
+    static constexpr int DefaultKeepCount = 7;      // backup a rotazione conservati
+    
+    explicit DatabaseBackup(const QString &databasePath, QObject *parent = nullptr);
+    ~DatabaseBackup();
+    
+    // Avvia la copia in un thread separato; emette progress() e finished()
+    bool start(const QString &destinationPath);
+    void cancel();
+    bool isRunning() const;
+    QString destinationPath() const { return m_destinationPath; }
+    
+    // Copia sincrona: progress riceve pagine copiate e totali, se restituisce
+    // false la copia viene interrotta. Il file di destinazione compare solo
+    // a copia completata (si scrive su un file temporaneo poi rinominato)
+    static bool backup(const QString &sourcePath, const QString &destinationPath,
+                       const std::function<bool(int, int)> &progress = nullptr,
+                       QString *errorMessage = nullptr);
+    
+    // Sostituisce il file del database con una copia del backup. Tutte le
+    // connessioni al database devono essere chiuse; il file corrente resta
+    // accanto all'originale con suffisso ".before-restore"
+    static bool restore(const QString &backupPath, const QString &databasePath,
+                        QString *errorMessage = nullptr);
+    
+    // Controllo di integrità (PRAGMA quick_check) di un file di backup
+    static bool verify(const QString &backupPath, QString *errorMessage = nullptr);
+    
+    // Backup a rotazione: <logbook>_aaaaMMgg_hhmmss.db nella cartella dei
+    // dati, una serie per ciascun file di logbook
+    static QString backupDirectory();
+    static QString rotatingBackupPath(const QString &databasePath);
+    static QStringList rotatingBackups(const QString &databasePath);    // dal più recente
+    static QDateTime lastRotatingBackupTime(const QString &databasePath);
+    static int pruneRotatingBackups(const QString &databasePath, int keepCount = DefaultKeepCount);
+
+signals:
+    void progress(int copiedPages, int totalPages);
+    void finished(bool success, const QString &errorMessage);
+
+private:
+    static QString errorText(int resultCode, const char *message);
+    
+    QString m_databasePath;
+    QString m_destinationPath;
+    QThread *m_thread;
+    std::atomic<bool> m_cancelled;
+};
+
+#endif // DATABASEBACKUP_H
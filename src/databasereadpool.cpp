@@ -0,0 +1,82 @@
+#include "databasereadpool.h"
+#include <QtCore/QThread>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QDebug>
+
+DatabaseReadPool::ReaderConnection::~ReaderConnection()
+{
+    DatabaseReadPool::destroyReader(database);
+}
+
+DatabaseReadPool::DatabaseReadPool(const QString &databasePath, int maxReaders)
+    : m_databasePath(databasePath)
+{
+    if (maxReaders <= 0) {
+        maxReaders = qBound(2, QThread::idealThreadCount(), 4);
+    }
+    
+    m_threadPool.setObjectName("DatabaseReadPool");
+    m_threadPool.setMaxThreadCount(maxReaders);
+    // I thread (e quindi le loro connessioni) restano vivi finché esiste il pool
+    m_threadPool.setExpiryTimeout(-1);
+}
+
+DatabaseReadPool::~DatabaseReadPool()
+{
+    // Completa le letture in corso; i thread escono con la distruzione del pool
+    m_threadPool.waitForDone();
+}
+
+int DatabaseReadPool::maxReaders() const
+{
+    return m_threadPool.maxThreadCount();
+}
+
+DatabaseReadPool::Metrics DatabaseReadPool::metrics() const
+{
+    QMutexLocker locker(&m_metricsMutex);
+    return m_metrics;
+}
+
+Database &DatabaseReadPool::checkout(const QElapsedTimer &queuedTimer)
+{
+    const qint64 waitMicros = queuedTimer.nsecsElapsed() / 1000;
+    
+    if (!m_readers.hasLocalData()) {
+        const QString connectionName = QString("qtlogbook_reader_%1_%2")
+            .arg(quintptr(this), 0, 16)
+            .arg(quintptr(QThread::currentThread()), 0, 16);
+        
+        ReaderConnection *connection = new ReaderConnection;
+        connection->database = new Database(connectionName);
+        if (!connection->database->initializeReadOnly(m_databasePath)) {
+            qWarning() << "Pool letture: apertura connessione fallita:" << connection->database->lastError();
+        }
+        m_readers.setLocalData(connection);
+        
+        QMutexLocker locker(&m_metricsMutex);
+        m_metrics.openConnections++;
+    }
+    
+    {
+        QMutexLocker locker(&m_metricsMutex);
+        m_metrics.queuedRequests--;
+        m_metrics.activeReaders++;
+        m_metrics.checkouts++;
+        m_metrics.totalWaitMicros += waitMicros;
+        m_metrics.maxWaitMicros = qMax(m_metrics.maxWaitMicros, waitMicros);
+    }
+    
+    return *m_readers.localData()->database;
+}
+
+void DatabaseReadPool::checkin()
+{
+    QMutexLocker locker(&m_metricsMutex);
+    m_metrics.activeReaders--;
+}
+
+void DatabaseReadPool::destroyReader(Database *database)
+{
+    delete database;
+}
@@ -0,0 +1,93 @@
+#ifndef DATABASEREADPOOL_H
+#define DATABASEREADPOOL_H
+
+#include <QtCore/QString>
+#include <QtCore/QFuture>
+#include <QtCore/QPromise>
+#include <QtCore/QMutex>
+#include <QtCore/QThreadPool>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QElapsedTimer>
+#include <functional>
+#include <memory>
+
+#include "database.h"
+
+// Pool di connessioni SQLite in sola lettura. Una QSqlDatabase non può
+// passare da un thread all'altro, quindi ogni thread del pool apre la propria
+// connessione la prima volta che serve e la riusa finché il pool esiste.
+// Con WAL le letture procedono in parallelo tra loro e con l'unico scrittore.
+class DatabaseReadPool
+{
+public:
+    struct Metrics {
+        quint64 checkouts = 0;          // letture servite
+        int openConnections = 0;        // connessioni in sola lettura aperte
+        int activeReaders = 0;          // letture in corso
+        int queuedRequests = 0;         // letture in attesa di un lettore libero
+        qint64 totalWaitMicros = 0;     // attesa cumulativa prima del checkout
+        qint64 maxWaitMicros = 0;
+        
+        double averageWaitMicros() const
+        {
+            return checkouts > 0 ? double(totalWaitMicros) / double(checkouts) : 0.0;
+        }
+    };
+    
+    explicit DatabaseReadPool(const QString &databasePath, int maxReaders = 0);
+    ~DatabaseReadPool();
+    
+    // Esegue una lettura su una connessione del pool; priorità più alta = prima
+    template <typename Result>
+    QFuture<Result> run(std::function<Result(Database &)> task, int priority = 0);
+    
+    int maxReaders() const;
+    Metrics metrics() const;
+
+private:
+    // Contenitore per QThreadStorage: chiude la connessione all'uscita del thread
+    struct ReaderConnection {
+        ~ReaderConnection();
+        Database *database = nullptr;
+    };
+    
+    Database &checkout(const QElapsedTimer &queuedTimer);
+    void checkin();
+    static void destroyReader(Database *database);
+    
+    QString m_databasePath;
+    
+    mutable QMutex m_metricsMutex;
+    Metrics m_metrics;
+    
+    // Dichiarato prima del pool di thread: i thread terminano (e chiudono le
+    // proprie connessioni) prima che lo storage venga distrutto
+    QThreadStorage<ReaderConnection *> m_readers;
+    QThreadPool m_threadPool;
+};
+
+template <typename Result>
+QFuture<Result> DatabaseReadPool::run(std::function<Result(Database &)> task, int priority)
+{
+    auto promise = std::make_shared<QPromise<Result>>();
+    QFuture<Result> future = promise->future();
+    promise->start();
+    
+    QElapsedTimer queuedTimer;
+    queuedTimer.start();
+    {
+        QMutexLocker locker(&m_metricsMutex);
+        m_metrics.queuedRequests++;
+    }
+    
+    m_threadPool.start([this, promise, task, queuedTimer]() {
+        Database &reader = checkout(queuedTimer);
+        promise->addResult(task(reader));
+        promise->finish();
+        checkin();
+    }, priority);
+    
+    return future;
+}
+
+#endif // DATABASEREADPOOL_H
@@ -0,0 +1,142 @@
+#include "dupeindex.h"
+#include "compactcontact.h"
+#include <algorithm>
+
+DupeIndex::DupeIndex()
+{
+}
+
+void DupeIndex::load(const QList<Database::DupeSummary> &summaries)
+{
+    clear();
+    m_worked.reserve(summaries.size());
+    
+    for (const Database::DupeSummary &summary : summaries) {
+        insert(summary.callsign, summary.band, summary.mode, summary.firstEpoch, summary.lastEpoch);
+    }
+}
+
+void DupeIndex::add(const Contact &contact)
+{
+    insert(contact.callsign(), contact.band(), contact.mode(), contact.utcEpoch(), contact.utcEpoch());
+}
+
+void DupeIndex::clear()
+{
+    m_worked.clear();
+    m_slotCount = 0;
+}
+
+bool DupeIndex::isDupe(const QString &callsign, const QString &band, const QString &mode,
+                       qint64 windowSeconds, qint64 nowEpoch, qint64 *lastEpoch) const
+{
+    const auto it = m_worked.constFind(callsign.toUpper());
+    if (it == m_worked.constEnd()) {
+        return false;
+    }
+    
+    // Banda e modo come id internati: il confronto è su interi
+    StringInterner &interner = StringInterner::instance();
+    const Slot *slot = findSlot(it.value(), interner.intern(band), interner.intern(mode));
+    if (!slot) {
+        return false;
+    }
+    
+    if (lastEpoch) {
+        *lastEpoch = slot->lastEpoch;
+    }
+    
+    if (windowSeconds <= 0 || slot->lastEpoch == Contact::InvalidEpoch) {
+        return true;
+    }
+    return nowEpoch - slot->lastEpoch <= windowSeconds;
+}
+
+DupeIndex::WorkedBefore DupeIndex::workedBefore(const QString &callsign, const QString &band,
+                                                const QString &mode) const
+{
+    WorkedBefore result;
+    const auto it = m_worked.constFind(callsign.toUpper());
+    if (it == m_worked.constEnd()) {
+        return result;
+    }
+    
+    StringInterner &interner = StringInterner::instance();
+    const quint32 bandId = interner.intern(band);
+    const quint32 modeId = interner.intern(mode);
+    
+    QList<quint32> bandIds;
+    QList<quint32> modeIds;
+    result.worked = true;
+    
+    for (const Slot &slot : it.value()) {
+        // L'epoch non valido (data illeggibile) non conta per primo e ultimo
+        if (slot.firstEpoch != Contact::InvalidEpoch
+            && (result.firstEpoch == Contact::InvalidEpoch || slot.firstEpoch < result.firstEpoch)) {
+            result.firstEpoch = slot.firstEpoch;
+        }
+        result.lastEpoch = qMax(result.lastEpoch, slot.lastEpoch);
+        
+        if (!bandIds.contains(slot.bandId)) {
+            bandIds.append(slot.bandId);
+        }
+        if (!modeIds.contains(slot.modeId)) {
+            modeIds.append(slot.modeId);
+        }
+        if (slot.bandId == bandId) {
+            result.newBand = false;
+        }
+        if (slot.modeId == modeId) {
+            result.newMode = false;
+        }
+        if (slot.bandId == bandId && slot.modeId == modeId) {
+            result.newSlot = false;
+        }
+    }
+    
+    for (quint32 id : std::as_const(bandIds)) {
+        result.bands.append(interner.value(id));
+    }
+    for (quint32 id : std::as_const(modeIds)) {
+        result.modes.append(interner.value(id));
+    }
+    result.bands.sort();
+    result.modes.sort();
+    
+    return result;
+}
+
+const DupeIndex::Slot *DupeIndex::findSlot(const QList<Slot> &entries, quint32 bandId, quint32 modeId)
+{
+    for (const Slot &slot : entries) {
+        if (slot.bandId == bandId && slot.modeId == modeId) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+void DupeIndex::insert(const QString &callsign, const QString &band, const QString &mode,
+                       qint64 firstEpoch, qint64 lastEpoch)
+{
+    StringInterner &interner = StringInterner::instance();
+    const quint32 bandId = interner.intern(band);
+    const quint32 modeId = interner.intern(mode);
+    
+    // Primo e ultimo come minimo e massimo: reinserire lo stesso QSO
+    // (coda write-behind, poi notifica dal database) non cambia nulla
+    QList<Slot> &entries = m_worked[callsign.toUpper()];
+    for (Slot &slot : entries) {
+        if (slot.bandId == bandId && slot.modeId == modeId) {
+            if (firstEpoch != Contact::InvalidEpoch
+                && (slot.firstEpoch == Contact::InvalidEpoch || firstEpoch < slot.firstEpoch)) {
+                slot.firstEpoch = firstEpoch;
+            }
+            slot.lastEpoch = qMax(slot.lastEpoch, lastEpoch);
+            return;
+        }
+    }
+    
+    entries.append(Slot{bandId, modeId, firstEpoch, lastEpoch});
+    m_slotCount++;
+}
@@ -0,0 +1,64 @@
+#ifndef DUPEINDEX_H
+#define DUPEINDEX_H
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QList>
+#include <QtCore/QHash>
+
+#include "contact.h"
+#include "database.h"
+
+// Insieme in memoria dei QSO già lavorati per nominativo, banda e modo, con
+// l'orario del primo e dell'ultimo collegamento. Caricato all'avvio dalla
+// query aggregata sull'indice composto e aggiornato ad ogni inserimento: il
+// controllo "dupe" e il riepilogo "già lavorato" mentre si digita il
+// nominativo non toccano il database.
+class DupeIndex
+{
+public:
+    // Riepilogo di un nominativo rispetto a banda e modo del form
+    struct WorkedBefore {
+        bool worked = false;
+        qint64 firstEpoch = Contact::InvalidEpoch;
+        qint64 lastEpoch = Contact::InvalidEpoch;
+        QStringList bands;      // bande e modi già collegati, in ordine alfabetico
+        QStringList modes;
+        bool newBand = true;    // banda mai collegata con questo nominativo
+        bool newMode = true;
+        bool newSlot = true;    // combinazione banda/modo mai collegata
+    };
+    
+    DupeIndex();
+    
+    void load(const QList<Database::DupeSummary> &summaries);
+    void add(const Contact &contact);
+    void clear();
+    int size() const { return m_slotCount; }
+    QStringList callsigns() const { return m_worked.keys(); }
+    
+    // Duplicato se lo stesso nominativo è già stato collegato sulla stessa
+    // banda e modo negli ultimi windowSeconds (0 = in qualsiasi momento)
+    bool isDupe(const QString &callsign, const QString &band, const QString &mode,
+                qint64 windowSeconds, qint64 nowEpoch, qint64 *lastEpoch = nullptr) const;
+    WorkedBefore workedBefore(const QString &callsign, const QString &band, const QString &mode) const;
+
+private:
+    // Un nominativo ha poche combinazioni banda/modo: un elenco compatto
+    // per nominativo è più piccolo e veloce di una tabella per combinazione
+    struct Slot {
+        quint32 bandId;
+        quint32 modeId;
+        qint64 firstEpoch;
+        qint64 lastEpoch;
+    };
+    
+    static const Slot *findSlot(const QList<Slot> &entries, quint32 bandId, quint32 modeId);
+    void insert(const QString &callsign, const QString &band, const QString &mode,
+                qint64 firstEpoch, qint64 lastEpoch);
+    
+    QHash<QString, QList<Slot>> m_worked;   // per nominativo in maiuscolo
+    int m_slotCount = 0;
+};
+
+#endif // DUPEINDEX_H
@@ -1,11 +1,13 @@
 #include "logbookmodel.h"
 #include <QtCore/QDateTime>
 #include <QtCore/QDebug>
+#include <algorithm>
+#include <numeric>
+#include <utility>
+#include <vector>
 
 LogbookModel::LogbookModel(QObject *parent)
     : QAbstractTableModel(parent)
-    , m_sortColumn(-1)
-    , m_sortOrder(Qt::AscendingOrder)
 {
 }
 
@@ -27,12 +29,12 @@ QVariant LogbookModel::data(const QModelIndex &index, int role) const
         return QVariant();
     }
     
-    const Contact &contact = m_filteredContacts.at(index.row());
+    const CompactContact &contact = m_filteredContacts.at(index.row());
     
     if (role == Qt::DisplayRole) {
         switch (index.column()) {
         case ColumnDateTime:
-            return formatDateTime(contact.dateTime());
+            return formatDateTime(contact.utcEpoch());
         case ColumnCallsign:
             return contact.callsign();
         case ColumnBand:
@@ -50,6 +52,14 @@ QVariant LogbookModel::data(const QModelIndex &index, int role) const
         case ColumnOperator:
             return contact.operatorCall();
         }
+    } else if (role == ContactIdRole) {
+        return contact.id();
+    } else if (role == EpochRole) {
+        return contact.hasDateTime() ? QVariant(contact.utcEpoch()) : QVariant();
+    } else if (role == RstSentValueRole) {
+        return rstSortValue(contact.rstSent());
+    } else if (role == RstReceivedValueRole) {
+        return rstSortValue(contact.rstReceived());
     } else if (role == Qt::TextAlignmentRole) {
         switch (index.column()) {
         case ColumnDateTime:
@@ -102,38 +112,96 @@ Qt::ItemFlags LogbookModel::flags(const QModelIndex &index) const
 }
 
 void LogbookModel::setContacts(const QList<Contact> &contacts)
+{
+    QList<CompactContact> compactContacts;
+    compactContacts.reserve(contacts.size());
+    for (const Contact &contact : contacts) {
+        compactContacts.append(CompactContact(contact));
+    }
+    setContacts(compactContacts);
+}
+
+void LogbookModel::setContacts(const QList<CompactContact> &contacts)
 {
     beginResetModel();
     m_contacts = contacts;
+    m_contactIndex.clear();
+    m_contactIndex.reserve(contacts.size());
+    for (int i = 0; i < m_contacts.size(); ++i) {
+        m_contactIndex.insert(m_contacts.at(i).id(), i);
+    }
     applyFilter();
     endResetModel();
 }
 
 void LogbookModel::addContact(const Contact &contact)
 {
-    beginInsertRows(QModelIndex(), 0, 0);
-    m_contacts.prepend(contact);
-    applyFilter();
+    const CompactContact compactContact(contact);
+    m_contactIndex.insert(compactContact.id(), m_contacts.size());
+    m_contacts.append(compactContact);
+    
+    if (matchesFilter(compactContact)) {
+        insertFilteredRow(compactContact);
+    }
+}
+
+void LogbookModel::insertFilteredRow(const CompactContact &contact)
+{
+    // Con un ordinamento attivo la riga va nella sua posizione ordinata
+    // (ricerca binaria sulle chiavi precalcolate), altrimenti in cima
+    RowSortKey key = sortKeyFor(contact);
+    const int row = m_sortColumns.isEmpty() ? 0 : insertionRow(key);
+    
+    beginInsertRows(QModelIndex(), row, row);
+    m_filteredContacts.insert(row, contact);
+    m_sortKeys.insert(row, std::move(key));
     endInsertRows();
 }
 
-void LogbookModel::updateContact(int row, const Contact &contact)
+void LogbookModel::updateContact(int row, const Contact &updatedContact)
 {
     if (row >= 0 && row < m_filteredContacts.size()) {
+        const CompactContact contact(updatedContact);
+        
         // Trova l'indice nel vettore originale
-        int originalIndex = -1;
-        for (int i = 0; i < m_contacts.size(); ++i) {
-            if (m_contacts[i].id() == m_filteredContacts[row].id()) {
-                originalIndex = i;
-                break;
+        const int originalIndex = contactIndexForId(m_filteredContacts[row].id());
+        if (originalIndex < 0) {
+            return;
+        }
+        
+        m_contacts[originalIndex] = contact;
+        
+        // Il contatto modificato non soddisfa più il filtro: esce dalla vista
+        if (!matchesFilter(contact)) {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_filteredContacts.removeAt(row);
+            m_sortKeys.removeAt(row);
+            endRemoveRows();
+            return;
+        }
+        
+        RowSortKey key = sortKeyFor(contact);
+        int targetRow = row;
+        if (!m_sortColumns.isEmpty()) {
+            // La ricerca include ancora la vecchia riga: se cade prima del
+            // punto di inserimento, la posizione finale scala di uno
+            targetRow = insertionRow(key);
+            if (targetRow > row) {
+                --targetRow;
             }
         }
         
-        if (originalIndex >= 0) {
-            m_contacts[originalIndex] = contact;
-            applyFilter();
-            emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
+        if (targetRow != row) {
+            const int destination = targetRow > row ? targetRow + 1 : targetRow;
+            beginMoveRows(QModelIndex(), row, row, QModelIndex(), destination);
+            m_filteredContacts.move(row, targetRow);
+            m_sortKeys.move(row, targetRow);
+            endMoveRows();
         }
+        
+        m_filteredContacts[targetRow] = contact;
+        m_sortKeys[targetRow] = std::move(key);
+        emit dataChanged(index(targetRow, 0), index(targetRow, columnCount() - 1));
     }
 }
 
@@ -142,33 +210,136 @@ void LogbookModel::removeContact(int row)
     if (row >= 0 && row < m_filteredContacts.size()) {
         beginRemoveRows(QModelIndex(), row, row);
         
-        // Trova e rimuovi dal vettore originale
-        int contactId = m_filteredContacts[row].id();
-        for (int i = 0; i < m_contacts.size(); ++i) {
-            if (m_contacts[i].id() == contactId) {
-                m_contacts.removeAt(i);
-                break;
-            }
+        const int contactIndex = contactIndexForId(m_filteredContacts[row].id());
+        if (contactIndex >= 0) {
+            removeContactAt(contactIndex);
         }
         
-        applyFilter();
+        // Le righe restanti sono già ordinate: nessun ricalcolo del filtro
+        m_filteredContacts.removeAt(row);
+        m_sortKeys.removeAt(row);
         endRemoveRows();
     }
 }
 
+void LogbookModel::applyChanges(const QList<Contact> &upserted, const QList<int> &removedIds)
+{
+    // Applica solo le differenze: un segnale di inserimento, spostamento o
+    // rimozione per riga, senza reset (selezione e scorrimento restano)
+    for (int contactId : removedIds) {
+        const int row = filteredRowForId(contactId);
+        if (row >= 0) {
+            removeContact(row);
+        } else {
+            // Contatto nascosto dal filtro: basta toglierlo dall'elenco completo
+            const int contactIndex = contactIndexForId(contactId);
+            if (contactIndex >= 0) {
+                removeContactAt(contactIndex);
+            }
+        }
+    }
+    
+    for (const Contact &contact : upserted) {
+        if (!m_contactIndex.contains(contact.id())) {
+            addContact(contact);
+            continue;
+        }
+        
+        const int row = filteredRowForId(contact.id());
+        if (row >= 0) {
+            updateContact(row, contact);
+        } else {
+            // Contatto finora nascosto dal filtro: può diventare visibile
+            const CompactContact compactContact(contact);
+            const int contactIndex = contactIndexForId(contact.id());
+            if (contactIndex >= 0) {
+                m_contacts[contactIndex] = compactContact;
+            }
+            if (matchesFilter(compactContact)) {
+                insertFilteredRow(compactContact);
+            }
+        }
+    }
+}
+
+int LogbookModel::filteredRowForId(int contactId) const
+{
+    const int contactIndex = contactIndexForId(contactId);
+    if (contactIndex < 0) {
+        return -1;
+    }
+    
+    // Senza ordinamento le righe non hanno una posizione calcolabile
+    if (m_sortColumns.isEmpty()) {
+        for (int row = 0; row < m_filteredContacts.size(); ++row) {
+            if (m_filteredContacts.at(row).id() == contactId) {
+                return row;
+            }
+        }
+        return -1;
+    }
+    
+    // Un indice id -> riga andrebbe aggiornato per tutte le righe successive
+    // a ogni inserimento ordinato: la riga si trova invece per ricerca binaria
+    // sulla chiave del contatto, scorrendo solo le righe a chiave uguale
+    const RowSortKey key = sortKeyFor(m_contacts.at(contactIndex));
+    const auto range = std::equal_range(m_sortKeys.cbegin(), m_sortKeys.cend(), key,
+                                        [this](const RowSortKey &a, const RowSortKey &b) {
+        return compareKeys(a, b) < 0;
+    });
+    for (auto it = range.first; it != range.second; ++it) {
+        const int row = static_cast<int>(it - m_sortKeys.cbegin());
+        if (m_filteredContacts.at(row).id() == contactId) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+int LogbookModel::contactIndexForId(int contactId) const
+{
+    return m_contactIndex.value(contactId, -1);
+}
+
+void LogbookModel::removeContactAt(int contactIndex)
+{
+    // L'ultimo contatto prende il posto del rimosso: un solo indice da aggiornare
+    const int lastIndex = m_contacts.size() - 1;
+    m_contactIndex.remove(m_contacts.at(contactIndex).id());
+    if (contactIndex != lastIndex) {
+        m_contacts[contactIndex] = std::move(m_contacts[lastIndex]);
+        m_contactIndex.insert(m_contacts.at(contactIndex).id(), contactIndex);
+    }
+    m_contacts.removeLast();
+}
+
 Contact LogbookModel::getContact(int row) const
 {
     if (row >= 0 && row < m_filteredContacts.size()) {
-        return m_filteredContacts[row];
+        return m_filteredContacts[row].toContact();
     }
     return Contact();
 }
 
+bool LogbookModel::findContact(int contactId, Contact *contact) const
+{
+    const int contactIndex = contactIndexForId(contactId);
+    if (contactIndex < 0) {
+        return false;
+    }
+    if (contact) {
+        *contact = m_contacts.at(contactIndex).toContact();
+    }
+    return true;
+}
+
 void LogbookModel::clear()
 {
     beginResetModel();
     m_contacts.clear();
+    m_contactIndex.clear();
     m_filteredContacts.clear();
+    m_sortKeys.clear();
     endResetModel();
 }
 
@@ -185,74 +356,181 @@ void LogbookModel::sort(int column, Qt::SortOrder order)
         return;
     }
     
-    m_sortColumn = column;
-    m_sortOrder = order;
+    // L'ordine precedente resta come criterio secondario (es. clic su
+    // Data/Ora e poi su Banda = banda, poi data/ora). La catena completa sta
+    // in m_sortColumns, non solo nell'ordine corrente delle righe: anche
+    // applyFilter(), che riparte da m_contacts, la riapplica per intero
+    QList<SortColumn> columns{{column, order}};
+    for (const SortColumn &sortColumn : std::as_const(m_sortColumns)) {
+        if (columns.size() >= MaxSortColumns) {
+            break;
+        }
+        if (sortColumn.column != column) {
+            columns.append(sortColumn);
+        }
+    }
+    setSortColumns(columns);
+}
+
+void LogbookModel::setSortColumns(const QList<SortColumn> &columns)
+{
+    m_sortColumns.clear();
+    m_sortSigns.clear();
+    for (const SortColumn &sortColumn : columns) {
+        if (sortColumn.column >= 0 && sortColumn.column < ColumnCount) {
+            m_sortColumns.append(sortColumn);
+            m_sortSigns.append(sortColumn.order == Qt::AscendingOrder ? 1 : -1);
+        }
+    }
     
-    beginResetModel();
+    if (m_sortColumns.isEmpty()) {
+        return;
+    }
+    
+    // Nessun reset del modello: selezione e posizione di scorrimento
+    // seguono le righe tramite la rimappatura degli indici persistenti
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+    sortRows(persistentIndexList());
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+void LogbookModel::sortRows(const QModelIndexList &persistentBefore)
+{
+    const int rowCount = m_filteredContacts.size();
     
-    std::sort(m_filteredContacts.begin(), m_filteredContacts.end(), 
-              [this](const Contact &a, const Contact &b) -> bool {
+    // Le chiavi vengono calcolate una sola volta per riga, non ad ogni confronto
+    m_sortKeys.clear();
+    m_sortKeys.reserve(rowCount);
+    for (const CompactContact &contact : std::as_const(m_filteredContacts)) {
+        m_sortKeys.append(sortKeyFor(contact));
+    }
+    
+    if (m_sortColumns.isEmpty()) {
+        return;
+    }
+    
+    // Ordina una permutazione di indici invece dei contatti stessi
+    std::vector<int> permutation(rowCount);
+    std::iota(permutation.begin(), permutation.end(), 0);
+    std::stable_sort(permutation.begin(), permutation.end(), [this](int a, int b) {
+        return compareKeys(m_sortKeys.at(a), m_sortKeys.at(b)) < 0;
+    });
+    
+    QList<CompactContact> sortedContacts;
+    QList<RowSortKey> sortedKeys;
+    sortedContacts.reserve(rowCount);
+    sortedKeys.reserve(rowCount);
+    std::vector<int> newRowOf(rowCount);
+    
+    for (int newRow = 0; newRow < rowCount; ++newRow) {
+        const int oldRow = permutation[newRow];
+        newRowOf[oldRow] = newRow;
+        sortedContacts.append(std::move(m_filteredContacts[oldRow]));
+        sortedKeys.append(std::move(m_sortKeys[oldRow]));
+    }
+    
+    m_filteredContacts = std::move(sortedContacts);
+    m_sortKeys = std::move(sortedKeys);
+    
+    if (persistentBefore.isEmpty()) {
+        return;
+    }
+    
+    QModelIndexList persistentAfter;
+    persistentAfter.reserve(persistentBefore.size());
+    for (const QModelIndex &oldIndex : persistentBefore) {
+        if (oldIndex.isValid() && oldIndex.row() < rowCount) {
+            persistentAfter.append(index(newRowOf[oldIndex.row()], oldIndex.column()));
+        } else {
+            persistentAfter.append(QModelIndex());
+        }
+    }
+    changePersistentIndexList(persistentBefore, persistentAfter);
+}
+
+LogbookModel::RowSortKey LogbookModel::sortKeyFor(const CompactContact &contact) const
+{
+    RowSortKey key;
+    for (const SortColumn &sortColumn : m_sortColumns) {
+        key.append(columnSortKey(contact, sortColumn.column));
+    }
+    return key;
+}
+
+int LogbookModel::compareKeys(const RowSortKey &a, const RowSortKey &b) const
+{
+    // Il verso di ordinamento è un segno precalcolato, non un ramo per confronto
+    for (int i = 0; i < a.size(); ++i) {
+        const SortKey &keyA = a[i];
+        const SortKey &keyB = b[i];
         
-        switch (m_sortColumn) {
-        case ColumnDateTime:
-            if (m_sortOrder == Qt::AscendingOrder) {
-                return a.dateTime() < b.dateTime();
-            } else {
-                return a.dateTime() > b.dateTime();
-            }
-        case ColumnCallsign:
-            if (m_sortOrder == Qt::AscendingOrder) {
-                return a.callsign() < b.callsign();
-            } else {
-                return a.callsign() > b.callsign();
-            }
-        case ColumnBand:
-            if (m_sortOrder == Qt::AscendingOrder) {
-                return a.band() < b.band();
-            } else {
-                return a.band() > b.band();
-            }
-        case ColumnMode:
-            if (m_sortOrder == Qt::AscendingOrder) {
-                return a.mode() < b.mode();
-            } else {
-                return a.mode() > b.mode();
-            }
-        case ColumnRSTSent:
-            if (m_sortOrder == Qt::AscendingOrder) {
-                return a.rstSent() < b.rstSent();
-            } else {
-                return a.rstSent() > b.rstSent();
-            }
-        case ColumnRSTReceived:
-            if (m_sortOrder == Qt::AscendingOrder) {
-                return a.rstReceived() < b.rstReceived();
-            } else {
-                return a.rstReceived() > b.rstReceived();
-            }
-        case ColumnDXCC:
-            if (m_sortOrder == Qt::AscendingOrder) {
-                return a.dxcc() < b.dxcc();
-            } else {
-                return a.dxcc() > b.dxcc();
-            }
-        case ColumnLocator:
-            if (m_sortOrder == Qt::AscendingOrder) {
-                return a.locator() < b.locator();
-            } else {
-                return a.locator() > b.locator();
-            }
-        case ColumnOperator:
-            if (m_sortOrder == Qt::AscendingOrder) {
-                return a.operatorCall() < b.operatorCall();
-            } else {
-                return a.operatorCall() > b.operatorCall();
-            }
+        int result = (keyA.number > keyB.number) - (keyA.number < keyB.number);
+        if (result == 0) {
+            const int textResult = keyA.text.compare(keyB.text);
+            result = (textResult > 0) - (textResult < 0);
         }
-        return false;
-    });
+        
+        if (result != 0) {
+            return result * m_sortSigns[i];
+        }
+    }
+    return 0;
+}
+
+LogbookModel::SortKey LogbookModel::columnSortKey(const CompactContact &contact, int column)
+{
+    SortKey key;
     
-    endResetModel();
+    switch (column) {
+    case ColumnDateTime:
+        key.number = contact.utcEpoch();
+        break;
+    case ColumnCallsign:
+        key.text = collationKey(contact.callsign());
+        break;
+    case ColumnBand:
+        key.text = collationKey(contact.band());
+        break;
+    case ColumnMode:
+        key.text = collationKey(contact.mode());
+        break;
+    case ColumnRSTSent:
+        key.number = rstSortValue(contact.rstSent());
+        break;
+    case ColumnRSTReceived:
+        key.number = rstSortValue(contact.rstReceived());
+        break;
+    case ColumnDXCC:
+        key.text = collationKey(contact.dxcc());
+        break;
+    case ColumnLocator:
+        key.text = collationKey(contact.locator());
+        break;
+    case ColumnOperator:
+        key.text = collationKey(contact.operatorCall());
+        break;
+    }
+    
+    return key;
+}
+
+qint64 LogbookModel::rstSortValue(const QString &rst)
+{
+    // Numeri "tagliati" del CW (5NN = 599, T = 0) e valori dB FT8 (+05, -12)
+    QString digits = rst;
+    digits.replace(QLatin1Char('N'), QLatin1Char('9'));
+    digits.replace(QLatin1Char('T'), QLatin1Char('0'));
+    
+    bool ok;
+    const int value = digits.toInt(&ok);
+    return ok ? value : 0;
+}
+
+QByteArray LogbookModel::collationKey(const QString &text)
+{
+    // L'ordine dei byte UTF-8 coincide con l'ordine dei code point:
+    // la chiave si confronta con un semplice memcmp
+    return text.toCaseFolded().toUtf8();
 }
 
 void LogbookModel::setFilter(const QString &filter)
@@ -270,21 +548,81 @@ void LogbookModel::applyFilter()
     if (m_filter.isEmpty()) {
         m_filteredContacts = m_contacts;
     } else {
-        QString filterLower = m_filter.toLower();
-        
-        for (const Contact &contact : m_contacts) {
-            if (contact.callsign().toLower().contains(filterLower) ||
-                contact.band().toLower().contains(filterLower) ||
-                contact.mode().toLower().contains(filterLower) ||
-                contact.dxcc().toLower().contains(filterLower) ||
-                contact.locator().toLower().contains(filterLower)) {
+        for (const CompactContact &contact : std::as_const(m_contacts)) {
+            if (matchesFilter(contact)) {
                 m_filteredContacts.append(contact);
             }
         }
     }
+    
+    sortRows();
+}
+
+bool LogbookModel::matchesFilter(const CompactContact &contact) const
+{
+    if (m_filter.isEmpty()) {
+        return true;
+    }
+    
+    return contact.callsign().contains(m_filter, Qt::CaseInsensitive) ||
+           contact.band().contains(m_filter, Qt::CaseInsensitive) ||
+           contact.mode().contains(m_filter, Qt::CaseInsensitive) ||
+           contact.dxcc().contains(m_filter, Qt::CaseInsensitive) ||
+           contact.locator().contains(m_filter, Qt::CaseInsensitive);
+}
+
+int LogbookModel::insertionRow(const RowSortKey &key) const
+{
+    // upper_bound: a parità di chiave la nuova riga va dopo le esistenti,
+    // come farebbe l'ordinamento stabile
+    const auto position = std::upper_bound(m_sortKeys.cbegin(), m_sortKeys.cend(), key,
+                                           [this](const RowSortKey &a, const RowSortKey &b) {
+        return compareKeys(a, b) < 0;
+    });
+    return static_cast<int>(position - m_sortKeys.cbegin());
 }
 
-QString LogbookModel::formatDateTime(const QDateTime &dateTime) const
+QString LogbookModel::formatDateTime(qint64 utcEpoch)
 {
-    return dateTime.toString("yyyy-MM-dd hh:mm");
-}
\ No newline at end of file
+    if (utcEpoch == Contact::InvalidEpoch) {
+        return QString();
+    }
+    
+    // Chiamata per ogni cella visibile ad ogni repaint: conversione civile
+    // diretta dai giorni dall'epoch (algoritmo di H. Hinnant), senza
+    // QDateTime né formattazione dipendente dal locale
+    qint64 days = utcEpoch / 86400;
+    qint64 secondsOfDay = utcEpoch % 86400;
+    if (secondsOfDay < 0) {
+        secondsOfDay += 86400;
+        --days;
+    }
+    
+    days += 719468;
+    const qint64 era = (days >= 0 ? days : days - 146096) / 146097;
+    const qint64 dayOfEra = days - era * 146097;
+    const qint64 yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const qint64 dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const qint64 monthIndex = (5 * dayOfYear + 2) / 153;
+    const int day = int(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    const int month = int(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+    const qint64 year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+    
+    if (year < 0 || year > 9999) {
+        return QDateTime::fromSecsSinceEpoch(utcEpoch, QTimeZone::utc()).toString("yyyy-MM-dd hh:mm");
+    }
+    
+    const int hour = int(secondsOfDay / 3600);
+    const int minute = int(secondsOfDay % 3600 / 60);
+    
+    // "yyyy-MM-dd hh:mm"
+    const auto digit = [](qint64 value) { return QChar(char16_t(u'0' + value % 10)); };
+    const QChar text[16] = {
+        digit(year / 1000), digit(year / 100), digit(year / 10), digit(year), u'-',
+        digit(month / 10), digit(month), u'-',
+        digit(day / 10), digit(day), u' ',
+        digit(hour / 10), digit(hour), u':',
+        digit(minute / 10), digit(minute)
+    };
+    return QString(text, 16);
+}
@@ -3,9 +3,13 @@
 
 #include <QtCore/QAbstractTableModel>
 #include <QtCore/QList>
+#include <QtCore/QHash>
 #include <QtCore/QString>
 #include <QtCore/QDateTime>
+#include <QtCore/QByteArray>
+#include <QtCore/QVarLengthArray>
 #include "contact.h"
+#include "compactcontact.h"
 
 class LogbookModel : public QAbstractTableModel
 {
@@ -25,6 +29,23 @@ public:
         ColumnCount
     };
 
+    // Valori grezzi tipizzati: ordinamento e delegate non analizzano stringhe
+    enum Role {
+        ContactIdRole = Qt::UserRole + 1,
+        EpochRole,              // data/ora UTC in secondi dall'epoch (qint64)
+        RstSentValueRole,       // RST inviato come intero (5NN = 599, -12 dB = -12)
+        RstReceivedValueRole    // RST ricevuto come intero
+    };
+
+    // Colonne ricordate dai clic sull'intestazione, la più recente per prima
+    static constexpr int MaxSortColumns = 3;
+
+    // Colonna di ordinamento (più colonne = ordinamento multi-colonna stabile)
+    struct SortColumn {
+        int column;
+        Qt::SortOrder order;
+    };
+
     explicit LogbookModel(QObject *parent = nullptr);
 
     // QAbstractTableModel interface
@@ -36,27 +57,59 @@ public:
 
     // Data management
     void setContacts(const QList<Contact> &contacts);
+    void setContacts(const QList<CompactContact> &contacts);
     void addContact(const Contact &contact);
     void updateContact(int row, const Contact &contact);
     void removeContact(int row);
+    void applyChanges(const QList<Contact> &upserted, const QList<int> &removedIds);
     Contact getContact(int row) const;
+    bool findContact(int contactId, Contact *contact) const;
+    int contactCount() const { return m_contacts.size(); }
+    bool containsContact(int contactId) const { return m_contactIndex.contains(contactId); }
     void clear();
     void refresh();
 
     // Sorting and filtering
     void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+    void setSortColumns(const QList<SortColumn> &columns);
+    QList<SortColumn> sortColumns() const { return m_sortColumns; }
     void setFilter(const QString &filter);
     QString getFilter() const { return m_filter; }
 
 private:
+    // Chiave di ordinamento precalcolata per una colonna: intero (epoch, RST)
+    // oppure chiave di collazione confrontabile byte per byte
+    struct SortKey {
+        qint64 number = 0;
+        QByteArray text;
+    };
+    using RowSortKey = QVarLengthArray<SortKey, MaxSortColumns>;
+
     void applyFilter();
-    QString formatDateTime(const QDateTime &dateTime) const;
+    bool matchesFilter(const CompactContact &contact) const;
+    void insertFilteredRow(const CompactContact &contact);
+    int filteredRowForId(int contactId) const;
+    int contactIndexForId(int contactId) const;
+    void removeContactAt(int contactIndex);
+    int insertionRow(const RowSortKey &key) const;
+    void sortRows(const QModelIndexList &persistentBefore = QModelIndexList());
+    RowSortKey sortKeyFor(const CompactContact &contact) const;
+    int compareKeys(const RowSortKey &a, const RowSortKey &b) const;
+    static SortKey columnSortKey(const CompactContact &contact, int column);
+    static qint64 rstSortValue(const QString &rst);
+    static QByteArray collationKey(const QString &text);
+    static QString formatDateTime(qint64 utcEpoch);
     
-    QList<Contact> m_contacts;
-    QList<Contact> m_filteredContacts;
+    // Record compatti: il modello può contenere centinaia di migliaia di QSO.
+    // m_contacts non ha un ordine proprio (la rimozione sposta l'ultimo al
+    // posto del tolto): l'ordine delle righe è quello di m_filteredContacts
+    QList<CompactContact> m_contacts;
+    QList<CompactContact> m_filteredContacts;
+    QHash<int, int> m_contactIndex;    // id -> indice in m_contacts
+    QList<RowSortKey> m_sortKeys;      // parallela a m_filteredContacts
     QString m_filter;
-    int m_sortColumn;
-    Qt::SortOrder m_sortOrder;
+    QList<SortColumn> m_sortColumns;
+    QVarLengthArray<int, MaxSortColumns> m_sortSigns; // +1 crescente, -1 decrescente
 };
 
 #endif // LOGBOOKMODEL_H
\ No newline at end of file
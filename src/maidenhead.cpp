@@ -0,0 +1,146 @@
+#include "maidenhead.h"
+#include <QtCore/QtMath>
+
+bool Maidenhead::isValid(const QString &locator)
+{
+    return toLatLon(locator, nullptr, nullptr);
+}
+
+bool Maidenhead::toLatLon(const QString &locator, double *latitude, double *longitude)
+{
+    const QString text = locator.trimmed().toUpper();
+    if (text.isEmpty() || text.size() > 8 || text.size() % 2 != 0) {
+        return false;
+    }
+    
+    // Coppie alternate lettere/cifre: campo (A-R, 20°x10°), quadrato (0-9),
+    // sottoquadrato (A-X), quadrato esteso (0-9). Ogni coppia divide la cella
+    // precedente; la longitudine ha sempre passo doppio della latitudine
+    double lon = -180.0;
+    double lat = -90.0;
+    double lonStep = 20.0;
+    double latStep = 10.0;
+    
+    for (int pair = 0; pair < text.size() / 2; ++pair) {
+        const QChar lonChar = text.at(pair * 2);
+        const QChar latChar = text.at(pair * 2 + 1);
+        int lonIndex;
+        int latIndex;
+        
+        if (pair % 2 == 0) {
+            const char16_t last = pair == 0 ? u'R' : u'X';
+            if (lonChar.unicode() < u'A' || lonChar.unicode() > last
+                || latChar.unicode() < u'A' || latChar.unicode() > last) {
+                return false;
+            }
+            lonIndex = lonChar.unicode() - 'A';
+            latIndex = latChar.unicode() - 'A';
+        } else {
+            if (!lonChar.isDigit() || !latChar.isDigit()) {
+                return false;
+            }
+            lonIndex = lonChar.digitValue();
+            latIndex = latChar.digitValue();
+        }
+        
+        if (pair > 0) {
+            const int divisions = pair % 2 == 0 ? 24 : 10;
+            lonStep /= divisions;
+            latStep /= divisions;
+        }
+        lon += lonIndex * lonStep;
+        lat += latIndex * latStep;
+    }
+    
+    if (latitude) {
+        *latitude = lat + latStep / 2.0;
+    }
+    if (longitude) {
+        *longitude = lon + lonStep / 2.0;
+    }
+    return true;
+}
+
+QString Maidenhead::fromLatLon(double latitude, double longitude, int length)
+{
+    double lon = qBound(0.0, longitude + 180.0, 359.999999);
+    double lat = qBound(0.0, latitude + 90.0, 179.999999);
+    double lonStep = 20.0;
+    double latStep = 10.0;
+    
+    QString locator;
+    for (int pair = 0; pair < qBound(1, length / 2, 4); ++pair) {
+        if (pair > 0) {
+            const int divisions = pair % 2 == 0 ? 24 : 10;
+            lonStep /= divisions;
+            latStep /= divisions;
+        }
+        
+        const int lonIndex = int(lon / lonStep);
+        const int latIndex = int(lat / latStep);
+        lon -= lonIndex * lonStep;
+        lat -= latIndex * latStep;
+        
+        const char base = pair % 2 == 0 ? 'A' : '0';
+        locator.append(QChar(base + lonIndex));
+        locator.append(QChar(base + latIndex));
+    }
+    
+    return locator;
+}
+
+double Maidenhead::distanceKm(double latitude1, double longitude1, double latitude2, double longitude2)
+{
+    const double phi1 = qDegreesToRadians(latitude1);
+    const double phi2 = qDegreesToRadians(latitude2);
+    const double deltaPhi = phi2 - phi1;
+    const double deltaLambda = qDegreesToRadians(longitude2 - longitude1);
+    
+    const double a = qSin(deltaPhi / 2) * qSin(deltaPhi / 2)
+        + qCos(phi1) * qCos(phi2) * qSin(deltaLambda / 2) * qSin(deltaLambda / 2);
+    return 2 * EarthRadiusKm * qAsin(qMin(1.0, qSqrt(a)));
+}
+
+QList<Maidenhead::BoundingBox> Maidenhead::boundingBoxes(double latitude, double longitude, double radiusKm)
+{
+    // Angolo al centro della Terra; l'ampiezza in longitudine è quella del
+    // parallelo tangente al cerchio (asin(sin r / cos lat))
+    const double angle = radiusKm / EarthRadiusKm;
+    const double deltaLatitude = qRadiansToDegrees(angle);
+    
+    BoundingBox box;
+    box.minLatitude = latitude - deltaLatitude;
+    box.maxLatitude = latitude + deltaLatitude;
+    box.minLongitude = -180.0;
+    box.maxLongitude = 180.0;
+    
+    const double cosLatitude = qCos(qDegreesToRadians(latitude));
+    if (box.minLatitude <= -90.0 || box.maxLatitude >= 90.0 || angle >= M_PI / 2
+        || qSin(angle) >= cosLatitude) {
+        // Il cerchio contiene un polo: tutte le longitudini
+        box.minLatitude = qMax(box.minLatitude, -90.0);
+        box.maxLatitude = qMin(box.maxLatitude, 90.0);
+        return {box};
+    }
+    
+    const double deltaLongitude = qRadiansToDegrees(qAsin(qSin(angle) / cosLatitude));
+    box.minLongitude = longitude - deltaLongitude;
+    box.maxLongitude = longitude + deltaLongitude;
+    
+    if (box.minLongitude < -180.0) {
+        BoundingBox wrapped = box;
+        wrapped.minLongitude = box.minLongitude + 360.0;
+        wrapped.maxLongitude = 180.0;
+        box.minLongitude = -180.0;
+        return {box, wrapped};
+    }
+    if (box.maxLongitude > 180.0) {
+        BoundingBox wrapped = box;
+        wrapped.minLongitude = -180.0;
+        wrapped.maxLongitude = box.maxLongitude - 360.0;
+        box.maxLongitude = 180.0;
+        return {box, wrapped};
+    }
+    
+    return {box};
+}
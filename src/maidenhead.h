@@ -0,0 +1,36 @@
+#ifndef MAIDENHEAD_H
+#define MAIDENHEAD_H
+
+#include <QtCore/QString>
+#include <QtCore/QList>
+
+// Conversione del locatore Maidenhead (2, 4, 6 o 8 caratteri) in coordinate
+// e calcoli sulla sfera per le query geografiche del logbook. La posizione di
+// un locatore è il centro del suo quadrato.
+class Maidenhead
+{
+public:
+    static constexpr double EarthRadiusKm = 6371.0;
+    static constexpr double HalfCircumferenceKm = 20015.1;  // π * EarthRadiusKm
+    
+    struct BoundingBox {
+        double minLatitude = 0.0;
+        double maxLatitude = 0.0;
+        double minLongitude = 0.0;
+        double maxLongitude = 0.0;
+    };
+    
+    static bool isValid(const QString &locator);
+    // false se il locatore non è valido; latitudine e longitudine in gradi
+    static bool toLatLon(const QString &locator, double *latitude, double *longitude);
+    static QString fromLatLon(double latitude, double longitude, int length = 6);
+    
+    // Distanza ortodromica (formula dell'emisenoverso)
+    static double distanceKm(double latitude1, double longitude1, double latitude2, double longitude2);
+    
+    // Rettangoli che contengono il cerchio di raggio radiusKm: due quando il
+    // cerchio attraversa l'antimeridiano, tutte le longitudini vicino ai poli
+    static QList<BoundingBox> boundingBoxes(double latitude, double longitude, double radiusKm);
+};
+
+#endif // MAIDENHEAD_H
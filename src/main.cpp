@@ -12,9 +12,12 @@
 #include <QtCore/QProcess>
 #include <QtCore/QStringList>
 #include <QtCore/QDebug>
+#include <QtCore/QTextStream>
 #include "mainwindow.h"
 #include "database.h"
 #include "setupdialog.h"
+#include "queryprofiler.h"
+#include "supercheckpartial.h"
 
 int main(int argc, char *argv[])
 {
@@ -29,17 +32,51 @@ int main(int argc, char *argv[])
     // Imposta il tema di base per una migliore integrazione
     app.setStyle(QStyleFactory::create("Fusion"));
     
-    // Inizializza il database prima di caricare il tema
-    Database *db = Database::instance();
-    QString dbPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QDir().mkpath(dbPath);
-    dbPath += "/logbook.db";
+    // Diagnostica: --slow-query-ms=N imposta la soglia del registro delle
+    // query lente, --query-stats stampa il profilo delle query all'uscita
+    const QStringList arguments = app.arguments();
+    for (const QString &argument : arguments) {
+        if (argument.startsWith("--slow-query-ms=")) {
+            bool ok = false;
+            const int millis = argument.section('=', 1).toInt(&ok);
+            if (ok) {
+                QueryProfiler::instance().setSlowThresholdMicros(qint64(millis) * 1000);
+            }
+        }
+    }
+    const bool dumpQueryStats = arguments.contains("--query-stats");
+    
+    // --self-check esegue le verifiche interne senza aprire la finestra;
+    // il codice di uscita è diverso da zero se una verifica fallisce
+    if (arguments.contains("--self-check")) {
+        QString checkError;
+        if (!SuperCheckPartial::selfCheck(&checkError)) {
+            QTextStream(stderr) << checkError << Qt::endl;
+            return 1;
+        }
+        QTextStream(stdout) << "Verifiche interne superate" << Qt::endl;
+        return 0;
+    }
     
-    if (!db->initialize(dbPath)) {
+    // Inizializza il database prima di caricare il tema: riapre l'ultimo
+    // logbook usato (il predefinito al primo avvio)
+    QString dbError;
+    if (!Database::switchLogbook(Database::lastLogbookPath(), &dbError)) {
         QMessageBox::critical(nullptr, "Errore Database", 
-                             "Impossibile inizializzare il database:\n" + db->lastError());
+                             "Impossibile inizializzare il database:\n" + dbError);
         return -1;
     }
+    Database *db = Database::instance();
+    
+    // --verify-query-plans controlla con EXPLAIN QUERY PLAN le forme di
+    // ContactQuery sul logbook corrente: uscita 1 se una legge tutta la tabella
+    if (arguments.contains("--verify-query-plans")) {
+        QStringList report;
+        const bool plansOk = db->verifyContactQueryPlans(&report);
+        QTextStream(stdout) << report.join('\n') << Qt::endl;
+        Database::destroy();
+        return plansOk ? 0 : 1;
+    }
     
     // Carica il tema in base alle impostazioni dell'utente
     QFile styleFile;
@@ -201,6 +238,11 @@ int main(int argc, char *argv[])
     window.show();
     
     int result = app.exec();
+    
+    if (dumpQueryStats) {
+        QTextStream(stdout) << QueryProfiler::instance().dump(1000) << Qt::endl;
+    }
+    
     Database::destroy();
     return result;
 }
\ No newline at end of file
@@ -20,20 +20,37 @@
 #include <QFileDialog>
 #include <QTimer>
 #include <QDateTime>
+#include <QTimeZone>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QFile>
+#include <QFileInfo>
 #include <QDebug>
 #include <QMenu>
 #include <QMenuBar>
 #include <QStatusBar>
 #include <QAction>
+#include <QFutureWatcher>
+#include <QProgressDialog>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QPlainTextEdit>
+#include <QFontDatabase>
+#include <QTextStream>
+#include <QSettings>
+#include "queryprofiler.h"
+#include "awardmatrixmodel.h"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , m_database(Database::instance())
+    , m_asyncDatabase(new AsyncDatabase(m_database->databasePath(), this))
+    , m_writeQueue(nullptr)
     , m_apiService(new ApiService(this))
+    , m_backup(new DatabaseBackup(m_database->databasePath(), this))
+    , m_backupTimer(new QTimer(this))
+    , m_maintenanceTimer(new QTimer(this))
     , m_dateTimeTimer(new QTimer(this))
 {
     setupUI();
@@ -52,6 +69,19 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_modeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onModeChanged);
     connect(m_apiService, &ApiService::callsignLookupFinished, this, &MainWindow::onCallsignLookupFinished);
     connect(m_apiService, &ApiService::callsignLookupError, this, &MainWindow::onCallsignLookupError);
+    connect(m_asyncDatabase, &AsyncDatabase::requestFailed, this, &MainWindow::onDatabaseError);
+    createWriteQueue();
+    
+    // Qualsiasi scrittura (thread GUI o thread database) aggiorna la tabella
+    // in modo incrementale a partire dal registro delle modifiche
+    connect(Database::notifier(), &DatabaseNotifier::contactsChanged, this, [this](qint64) {
+        updateContactsTable();
+    });
+    connect(m_callsignEdit, &QLineEdit::textChanged, this, &MainWindow::updateDupeStatus);
+    connect(m_bandCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::updateDupeStatus);
+    connect(m_modeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::updateDupeStatus);
+    connect(m_dxccEdit, &QLineEdit::textChanged, this, &MainWindow::updateAwardStatus);
+    connect(m_locatorEdit, &QLineEdit::textChanged, this, &MainWindow::updateAwardStatus);
     
     // Configure API service with saved credentials
     configureApiService();
@@ -69,6 +99,35 @@ MainWindow::MainWindow(QWidget *parent)
     
     // Carica i contatti esistenti
     updateContactsTable();
+    
+    // Lista master Super Check Partial scelta in una sessione precedente
+    const QString superCheckFile = QSettings().value("supercheck/masterFile").toString();
+    if (!superCheckFile.isEmpty()) {
+        loadSuperCheckList(superCheckFile);
+    }
+    
+    // Converte in background le date dei QSO registrati prima della colonna
+    // epoch; al termine l'indice dei duplicati vede anche quelle righe
+    QFutureWatcher<int> *backfillWatcher = new QFutureWatcher<int>(this);
+    connect(backfillWatcher, &QFutureWatcher<int>::finished, this, [this, backfillWatcher]() {
+        if (backfillWatcher->result() > 0) {
+            reloadDupeIndex();
+        }
+        backfillWatcher->deleteLater();
+    });
+    backfillWatcher->setFuture(m_asyncDatabase->backfillEpochs());
+    
+    // Il primo controllo del backup automatico parte a avvio completato
+    connect(m_backupTimer, &QTimer::timeout, this, &MainWindow::runScheduledBackup);
+    m_backupTimer->start(BackupCheckIntervalMs);
+    QTimer::singleShot(60000, this, &MainWindow::runScheduledBackup);
+    
+    m_maintenanceTimer->setSingleShot(true);
+    connect(m_maintenanceTimer, &QTimer::timeout, this, &MainWindow::runIdleMaintenance);
+    connect(m_callsignEdit, &QLineEdit::textChanged, this, [this]() {
+        m_maintenanceTimer->start(MaintenanceIdleMs);
+    });
+    m_maintenanceTimer->start(MaintenanceIdleMs);
 }
 
 MainWindow::~MainWindow()
@@ -77,6 +136,54 @@ MainWindow::~MainWindow()
     if (m_dateTimeTimer && m_dateTimeTimer->isActive()) {
         m_dateTimeTimer->stop();
     }
+    
+    // I QSO ancora in coda vanno scritti finché il thread database è attivo
+    // (i figli del QObject verrebbero distrutti dopo m_asyncDatabase)
+    stopDatabaseServices();
+    for (const LogbookSession &session : std::as_const(m_sessions)) {
+        delete session.writeQueue;
+    }
+}
+
+void MainWindow::createWriteQueue()
+{
+    m_writeQueue = new QsoWriteQueue(m_asyncDatabase, m_database->databasePath(), this);
+    
+    // Scritti: le righe provvisorie lasciano il posto a quelle definitive,
+    // già arrivate con la notifica contactsChanged
+    connect(m_writeQueue, &QsoWriteQueue::flushed, this, &MainWindow::removeTemporaryContacts);
+    connect(m_writeQueue, &QsoWriteQueue::flushFailed, this, [this](const QString &error) {
+        statusBar()->showMessage(QString("QSO in attesa di scrittura (%1): %2")
+                                 .arg(m_writeQueue->pendingCount()).arg(error), 10000);
+    });
+    // Scartato dopo troppi tentativi: la riga provvisoria sparisce e l'indice
+    // dei duplicati si ricarica dal database, il QSO resta nel file dei rifiutati
+    connect(m_writeQueue, &QsoWriteQueue::contactRejected, this, [this](const Contact &contact, const QString &error) {
+        removeTemporaryContacts({contact});
+        reloadDupeIndex();
+        QMessageBox::warning(this, "QSO non registrato",
+            QString("Il QSO con %1 (%2, %3 %4) non è stato scritto nel database dopo %5 tentativi:\n%6\n\n"
+                    "Il contatto è stato salvato in:\n%7")
+                .arg(contact.callsign(),
+                     contact.dateTime().toString("dd/MM/yyyy hh:mm"),
+                     contact.band(), contact.mode())
+                .arg(QsoWriteQueue::MaxAttempts)
+                .arg(error, QsoWriteQueue::rejectedPath(m_database->databasePath())));
+    });
+}
+
+void MainWindow::removeTemporaryContacts(const QList<Contact> &contacts)
+{
+    // I diplomi contano già la riga definitiva: si toglie quella provvisoria
+    QList<int> temporaryIds;
+    for (const Contact &contact : contacts) {
+        temporaryIds.append(contact.id());
+        m_awards.remove(contact);
+    }
+    if (m_awardsLoading && !contacts.isEmpty()) {
+        m_awardsStale = true;
+    }
+    m_contactsModel->applyChanges(QList<Contact>(), temporaryIds);
 }
 
 void MainWindow::setupUI()
@@ -129,9 +236,33 @@ void MainWindow::setupUI()
     // Connetti il segnale per convertire automaticamente in maiuscolo
     connect(m_callsignEdit, &QLineEdit::textEdited, this, &MainWindow::onCallsignTextEdited);
     
+    // Super check partial: il modello viene riempito a ogni tasto con le
+    // corrispondenze già ordinate, il completer non filtra
+    m_callsignCompleterModel = new QStandardItemModel(this);
+    m_callsignCompleter = new QCompleter(m_callsignCompleterModel, this);
+    m_callsignCompleter->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    m_callsignCompleter->setCaseSensitivity(Qt::CaseInsensitive);
+    m_callsignCompleter->setMaxVisibleItems(SuperCheckPartial::MaxMatches);
+    m_callsignEdit->setCompleter(m_callsignCompleter);
+    
     m_formLayout->addWidget(m_callsignLabel, 1, 0);
     m_formLayout->addWidget(m_callsignEdit, 1, 1);
     
+    // Avviso duplicato accanto al nominativo
+    m_dupeLabel = new QLabel();
+    m_dupeLabel->setObjectName("dupeLabel");
+    m_dupeLabel->setAccessibleName("<span lang=\"it\">Avviso contatto duplicato</span>");
+    m_dupeLabel->setToolTip("Indica se il nominativo è già stato collegato sulla stessa banda e modo");
+    m_formLayout->addWidget(m_dupeLabel, 1, 2);
+    
+    // Riepilogo "già lavorato" sotto l'avviso duplicato, accanto a banda e modo
+    m_workedLabel = new QLabel();
+    m_workedLabel->setObjectName("workedLabel");
+    m_workedLabel->setWordWrap(true);
+    m_workedLabel->setAccessibleName("<span lang=\"it\">Riepilogo collegamenti precedenti con il nominativo</span>");
+    m_workedLabel->setToolTip("Quando il nominativo è già stato collegato, su quali bande e modi, e se banda o modo sono nuovi");
+    m_formLayout->addWidget(m_workedLabel, 2, 2, 2, 1);
+    
     // Banda
     m_bandLabel = new QLabel("Banda:");
     m_bandLabel->setObjectName("fieldLabel");
@@ -204,6 +335,14 @@ void MainWindow::setupUI()
     m_formLayout->addWidget(m_locatorLabel, 7, 0);
     m_formLayout->addWidget(m_locatorEdit, 7, 1);
     
+    // Diplomi: DXCC o quadrato nuovi, o nuovi su banda e modo del form
+    m_awardLabel = new QLabel();
+    m_awardLabel->setObjectName("awardLabel");
+    m_awardLabel->setWordWrap(true);
+    m_awardLabel->setAccessibleName("<span lang=\"it\">Avviso nuova entità per i diplomi</span>");
+    m_awardLabel->setToolTip("Indica se DXCC o quadrato del locatore sono nuovi, o nuovi su questa banda e modo");
+    m_formLayout->addWidget(m_awardLabel, 6, 2, 2, 1);
+    
     // Operatore
     m_operatorLabel = new QLabel("Operatore:");
     m_operatorLabel->setObjectName("fieldLabel");
@@ -258,13 +397,15 @@ void MainWindow::setupUI()
     m_contactsTable->setShowGrid(true);
     m_contactsTable->setGridStyle(Qt::SolidLine);
     m_contactsTable->setFrameShape(QFrame::NoFrame); // Rimuovi il bordo esterno
+    m_contactsTable->setSortingEnabled(true); // Ordinamento da intestazione senza reset del modello
+    m_contactsTable->sortByColumn(LogbookModel::ColumnDateTime, Qt::DescendingOrder);
     m_contactsTable->setAccessibleName("<span lang=\"it\">Tabella dei contatti del logbook</span>");
     m_contactsTable->setAccessibleDescription("<span lang=\"it\">Tabella che mostra tutti i contatti registrati nel logbook</span>");
     
     m_mainLayout->addWidget(m_contactsTable);
     
     // Imposta il titolo della finestra e dimensioni ottimali
-    setWindowTitle("QT Logbook - Logbook Radioamatoriale");
+    updateWindowTitle();
     resize(900, 700); // Dimensioni leggermente maggiori per una migliore visualizzazione
     
     // Imposta lo stile per i widget principali
@@ -279,6 +420,12 @@ void MainWindow::setupMenuBar()
     // Menu File
     QMenu *fileMenu = menuBar()->addMenu("&File");
     
+    // Logbook: l'elenco dei logbook recenti viene ricostruito all'apertura
+    m_logbookMenu = fileMenu->addMenu("&Logbook");
+    connect(m_logbookMenu, &QMenu::aboutToShow, this, &MainWindow::updateLogbookMenu);
+    
+    fileMenu->addSeparator();
+    
     // Azioni ADIF
     m_importADIFAction = new QAction("&Importa ADIF...", this);
     m_importADIFAction->setShortcut(QKeySequence("Ctrl+I"));
@@ -292,6 +439,17 @@ void MainWindow::setupMenuBar()
     
     fileMenu->addSeparator();
     
+    // Azioni backup
+    m_backupAction = new QAction("&Backup database...", this);
+    connect(m_backupAction, &QAction::triggered, this, &MainWindow::onBackupDatabase);
+    fileMenu->addAction(m_backupAction);
+    
+    m_restoreAction = new QAction("&Ripristina backup...", this);
+    connect(m_restoreAction, &QAction::triggered, this, &MainWindow::onRestoreDatabase);
+    fileMenu->addAction(m_restoreAction);
+    
+    fileMenu->addSeparator();
+    
     m_exitAction = new QAction("&Esci", this);
     m_exitAction->setShortcut(QKeySequence::Quit);
     connect(m_exitAction, &QAction::triggered, qApp, &QApplication::quit);
@@ -300,6 +458,34 @@ void MainWindow::setupMenuBar()
     // Menu Strumenti
     QMenu *toolsMenu = menuBar()->addMenu("&Strumenti");
     
+    m_crossLogSearchAction = new QAction("&Cerca nominativo in tutti i logbook...", this);
+    connect(m_crossLogSearchAction, &QAction::triggered, this, &MainWindow::onCrossLogSearch);
+    toolsMenu->addAction(m_crossLogSearchAction);
+    
+    m_crossLogStatisticsAction = new QAction("S&tatistiche di tutti i logbook", this);
+    connect(m_crossLogStatisticsAction, &QAction::triggered, this, &MainWindow::onCrossLogStatistics);
+    toolsMenu->addAction(m_crossLogStatisticsAction);
+    
+    toolsMenu->addSeparator();
+    
+    m_archiveAction = new QAction("&Archivia QSO vecchi...", this);
+    connect(m_archiveAction, &QAction::triggered, this, &MainWindow::onArchiveContacts);
+    toolsMenu->addAction(m_archiveAction);
+    
+    m_queryDiagnosticsAction = new QAction("&Diagnostica database...", this);
+    connect(m_queryDiagnosticsAction, &QAction::triggered, this, &MainWindow::onQueryDiagnostics);
+    toolsMenu->addAction(m_queryDiagnosticsAction);
+    
+    m_superCheckAction = new QAction("Carica lista &Super Check Partial...", this);
+    connect(m_superCheckAction, &QAction::triggered, this, &MainWindow::onLoadSuperCheckList);
+    toolsMenu->addAction(m_superCheckAction);
+    
+    m_awardsAction = new QAction("Di&plomi...", this);
+    connect(m_awardsAction, &QAction::triggered, this, &MainWindow::onAwards);
+    toolsMenu->addAction(m_awardsAction);
+    
+    toolsMenu->addSeparator();
+    
     m_settingsAction = new QAction("&Impostazioni", this);
     connect(m_settingsAction, &QAction::triggered, this, &MainWindow::onSettings);
     toolsMenu->addAction(m_settingsAction);
@@ -391,14 +577,539 @@ void MainWindow::onAddContact()
     contact.setDxcc(m_dxccEdit->text());
     contact.setLocator(m_locatorEdit->text());
     
-    if (m_database->addContact(contact)) {
-        statusBar()->showMessage("Contatto aggiunto con successo", 3000);
-        clearForm();
+    // Write-behind: il QSO entra subito nel modello, nell'indice dei duplicati
+    // e nel journal su file; il thread database lo scrive insieme agli altri
+    // in coda entro QsoWriteQueue::FlushIntervalMs
+    const Contact queued = m_writeQueue->enqueue(contact);
+    applyContactChanges({queued}, QList<int>());
+    m_dupeIndex.add(queued);
+    m_superCheck.addCallsign(queued.callsign(), SuperCheckPartial::LogSource);
+    
+    clearForm();
+    statusBar()->showMessage("Contatto aggiunto con successo", 3000);
+}
+
+void MainWindow::onBackupDatabase()
+{
+    if (m_backup->isRunning()) {
+        QMessageBox::information(this, "Backup Database", "Un backup è già in corso, riprova tra poco.");
+        return;
+    }
+    
+    QString fileName = QFileDialog::getSaveFileName(this,
+        "Backup Database",
+        QString("%1/backup_logbook_%2.db")
+            .arg(DatabaseBackup::backupDirectory(),
+                 QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")),
+        "Database SQLite (*.db);;Tutti i file (*)");
+    
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    // La copia avviene a passi nel thread del backup, sull'istantanea di
+    // inizio copia: il logging continua, il dialogo mostra le pagine copiate
+    // e "Annulla" interrompe la copia al passo successivo
+    QProgressDialog *progressDialog = new QProgressDialog("Backup del database in corso...", "Annulla", 0, 100, this);
+    progressDialog->setWindowTitle("Backup Database");
+    progressDialog->setWindowModality(Qt::WindowModal);
+    progressDialog->setMinimumDuration(500);
+    progressDialog->setValue(0);
+    
+    connect(m_backup, &DatabaseBackup::progress, progressDialog, [progressDialog](int copiedPages, int totalPages) {
+        progressDialog->setValue(totalPages > 0 ? copiedPages * 100 / totalPages : 0);
+    });
+    connect(progressDialog, &QProgressDialog::canceled, m_backup, &DatabaseBackup::cancel);
+    connect(m_backup, &DatabaseBackup::finished, progressDialog, [this, progressDialog, fileName](bool success, const QString &error) {
+        progressDialog->reset();
+        progressDialog->deleteLater();
+        
+        if (!success) {
+            QMessageBox::critical(this, "Errore Backup",
+                                 "Errore durante la creazione del backup:\n" + error);
+            return;
+        }
+        
+        statusBar()->showMessage("Backup creato: " + fileName, 5000);
+    });
+    
+    m_backup->start(fileName);
+}
+
+void MainWindow::onRestoreDatabase()
+{
+    if (m_backup->isRunning()) {
+        QMessageBox::information(this, "Ripristina Backup", "Un backup è in corso, riprova al termine.");
+        return;
+    }
+    
+    QString fileName = QFileDialog::getOpenFileName(this,
+        "Ripristina Backup", DatabaseBackup::backupDirectory(),
+        "Database SQLite (*.db);;Tutti i file (*)");
+    
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    QString error;
+    if (!DatabaseBackup::verify(fileName, &error)) {
+        QMessageBox::critical(this, "Errore Ripristino", error);
+        return;
+    }
+    
+    const QString databasePath = m_database->databasePath();
+    int answer = QMessageBox::question(this, "Ripristina Backup",
+        QString("Il logbook corrente (contatti e impostazioni) verrà sostituito dal backup selezionato.\n\n"
+               "Il database attuale resterà salvato in:\n%1.before-restore\n\n"
+               "Continuare?").arg(databasePath),
+        QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+    
+    if (answer != QMessageBox::Yes) {
+        return;
+    }
+    
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    
+    // Il thread database e il pool di lettura tengono aperto il file: vengono
+    // fermati e ricreati dopo lo scambio
+    stopDatabaseServices();
+    const bool restored = m_database->restoreFromBackup(fileName);
+    resetDatabaseServices();
+    
+    QApplication::restoreOverrideCursor();
+    
+    if (!restored) {
+        QMessageBox::critical(this, "Errore Ripristino",
+                             "Impossibile ripristinare il backup:\n" + m_database->lastError());
+        return;
+    }
+    
+    QMessageBox::information(this, "Ripristino Completato",
+                           QString("Backup ripristinato con successo.\n\nContatti: %1")
+                           .arg(m_contactsModel->contactCount()));
+}
+
+void MainWindow::onArchiveContacts()
+{
+    const int currentYear = QDate::currentDate().year();
+    bool ok = false;
+    const int cutoffYear = QInputDialog::getInt(this, "Archivia QSO vecchi",
+        "Sposta negli archivi annuali i QSO precedenti al 1° gennaio dell'anno:",
+        currentYear - 1, 1900, currentYear, 1, &ok);
+    
+    if (!ok) {
+        return;
+    }
+    
+    // Copia e cancellazione nel thread database; la tabella si aggiorna dal
+    // registro modifiche, gli archivi restano consultabili dalle query
+    QFutureWatcher<int> *watcher = new QFutureWatcher<int>(this);
+    connect(watcher, &QFutureWatcher<int>::finished, this, [this, watcher, cutoffYear]() {
+        const int moved = watcher->result();
+        watcher->deleteLater();
+        
+        if (moved < 0) {
+            return; // Errore già segnalato da onDatabaseError
+        }
+        
+        QMessageBox::information(this, "Archiviazione Completata",
+                               QString("QSO precedenti al %1 archiviati: %2\n\nCartella archivi:\n%3")
+                               .arg(cutoffYear)
+                               .arg(moved)
+                               .arg(m_database->archiveDirectory()));
+    });
+    watcher->setFuture(m_asyncDatabase->archiveContactsBefore(cutoffYear));
+}
+
+void MainWindow::updateLogbookMenu()
+{
+    m_logbookMenu->clear();
+    
+    m_logbookMenu->addAction("&Nuovo logbook...", this, &MainWindow::onNewLogbook);
+    m_logbookMenu->addAction("&Apri logbook...", this, &MainWindow::onOpenLogbook);
+    m_logbookMenu->addSeparator();
+    
+    // Logbook recenti: quello attivo è spuntato
+    const QString current = m_database->databasePath();
+    const QStringList logbooks = Database::knownLogbooks();
+    for (const QString &path : logbooks) {
+        QAction *action = m_logbookMenu->addAction(Database::logbookName(path));
+        action->setToolTip(path);
+        action->setCheckable(true);
+        action->setChecked(QFileInfo(path) == QFileInfo(current));
+        connect(action, &QAction::triggered, this, [this, path]() {
+            switchToLogbook(path);
+        });
+    }
+}
+
+void MainWindow::onNewLogbook()
+{
+    QString fileName = QFileDialog::getSaveFileName(this,
+        "Nuovo Logbook", QFileInfo(Database::defaultLogbookPath()).absolutePath() + "/nuovo_logbook.db",
+        "Logbook (*.db);;Tutti i file (*)");
+    
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    // Il file viene creato e preparato all'apertura
+    switchToLogbook(fileName);
+}
+
+void MainWindow::onOpenLogbook()
+{
+    QString fileName = QFileDialog::getOpenFileName(this,
+        "Apri Logbook", QFileInfo(m_database->databasePath()).absolutePath(),
+        "Logbook (*.db);;Tutti i file (*)");
+    
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    switchToLogbook(fileName);
+}
+
+void MainWindow::switchToLogbook(const QString &path)
+{
+    const QString previousKey = QFileInfo(m_database->databasePath()).absoluteFilePath();
+    const QString key = QFileInfo(path).absoluteFilePath();
+    if (key == previousKey) {
+        return;
+    }
+    
+    QString error;
+    if (!Database::switchLogbook(path, &error)) {
+        QMessageBox::critical(this, "Errore Logbook", "Impossibile aprire il logbook:\n" + error);
+        return;
+    }
+    
+    // I QSO in coda si scrivono subito: la coda del logbook lasciato resta
+    // ferma e le righe provvisorie non restano nel suo modello
+    removeTemporaryContacts(m_writeQueue->drain());
+    
+    LogbookSession &previous = m_sessions[previousKey];
+    previous.asyncDatabase = m_asyncDatabase;
+    previous.writeQueue = m_writeQueue;
+    previous.backup = m_backup;
+    previous.contactsModel = m_contactsModel;
+    previous.contactsWatermark = m_contactsWatermark;
+    previous.dupeIndex = m_dupeIndex;
+    previous.awards = m_awards;
+    m_awardsLoading = false;
+    m_awardsStale = false;
+    
+    m_database = Database::instance();
+    const auto it = m_sessions.find(key);
+    if (it != m_sessions.end()) {
+        // Ritorno a un logbook già aperto: solo le modifiche nel frattempo
+        const LogbookSession session = it.value();
+        m_sessions.erase(it);
+        m_asyncDatabase = session.asyncDatabase;
+        m_writeQueue = session.writeQueue;
+        m_backup = session.backup;
+        m_contactsModel = session.contactsModel;
+        m_contactsWatermark = session.contactsWatermark;
+        m_dupeIndex = session.dupeIndex;
+        m_awards = session.awards;
+        m_contactsTable->setModel(m_contactsModel);
+        
         updateContactsTable();
+        if (session.reloadRequired) {
+            reloadDupeIndex();
+            reloadAwards();
+        }
     } else {
-        QMessageBox::critical(this, "Errore", 
-                             "Errore durante l'aggiunta del contatto:\n" + m_database->lastError());
+        // Primo accesso: servizi propri e caricamento completo
+        m_asyncDatabase = new AsyncDatabase(m_database->databasePath(), this);
+        connect(m_asyncDatabase, &AsyncDatabase::requestFailed, this, &MainWindow::onDatabaseError);
+        createWriteQueue();
+        m_backup = new DatabaseBackup(m_database->databasePath(), this);
+        m_contactsModel = new LogbookModel(this);
+        m_contactsTable->setModel(m_contactsModel);
+        m_contactsWatermark = -1;
+        m_dupeIndex.clear();
+        m_awards.clear();
+        
+        updateContactsTable();
+    }
+    
+    m_superCheck.setLogCallsigns(m_dupeIndex.callsigns());
+    updateDupeStatus();
+    configureApiService();
+    updateWindowTitle();
+    
+    // Logbook nuovo: chiede subito i dati dell'operatore
+    if (m_database->getOperatorCall().isEmpty()) {
+        QTimer::singleShot(100, this, &MainWindow::onSettings);
+    }
+}
+
+void MainWindow::markSessionReload(AsyncDatabase *source)
+{
+    // Caricamento finito dopo il cambio di logbook: il risultato appartiene
+    // al logbook lasciato, che si ricarica quando torna attivo
+    for (LogbookSession &session : m_sessions) {
+        if (session.asyncDatabase == source) {
+            session.reloadRequired = true;
+        }
+    }
+}
+
+void MainWindow::stopDatabaseServices()
+{
+    // La coda dei QSO si svuota (drain nel distruttore) finché il thread
+    // database che la scrive è ancora attivo; poi si ferma il thread, dopo
+    // aver completato le richieste in coda
+    delete m_writeQueue;
+    m_writeQueue = nullptr;
+    delete m_asyncDatabase;
+    m_asyncDatabase = nullptr;
+}
+
+void MainWindow::resetDatabaseServices()
+{
+    // Dopo il ripristino di un backup il file è un altro: thread database e
+    // pool di lettura vengono ricreati e il modello si ricarica da zero, il
+    // registro delle modifiche appartiene al file precedente
+    m_asyncDatabase = new AsyncDatabase(m_database->databasePath(), this);
+    connect(m_asyncDatabase, &AsyncDatabase::requestFailed, this, &MainWindow::onDatabaseError);
+    createWriteQueue();
+    
+    m_contactsWatermark = -1;
+    updateContactsTable();
+    configureApiService();
+    updateWindowTitle();
+}
+
+void MainWindow::updateWindowTitle()
+{
+    setWindowTitle(QString("QT Logbook - Logbook Radioamatoriale [%1]")
+                   .arg(Database::logbookName(m_database->databasePath())));
+}
+
+void MainWindow::onCrossLogSearch()
+{
+    bool ok = false;
+    const QString callsign = QInputDialog::getText(this, "Cerca in tutti i logbook",
+        "Nominativo:", QLineEdit::Normal, m_callsignEdit->text().trimmed(), &ok).trimmed().toUpper();
+    
+    if (!ok || callsign.isEmpty()) {
+        return;
+    }
+    
+    // Gli altri logbook vengono collegati in sola lettura dal pool di lettura
+    const QStringList logbooks = Database::knownLogbooks();
+    QFutureWatcher<QList<Database::WorkedEntry>> *watcher = new QFutureWatcher<QList<Database::WorkedEntry>>(this);
+    connect(watcher, &QFutureWatcher<QList<Database::WorkedEntry>>::finished, this, [this, watcher, callsign]() {
+        const QList<Database::WorkedEntry> entries = watcher->result();
+        watcher->deleteLater();
+        
+        if (entries.isEmpty()) {
+            QMessageBox::information(this, "Cerca in tutti i logbook",
+                                   QString("%1 non risulta in nessun logbook.").arg(callsign));
+            return;
+        }
+        
+        QStringList lines;
+        for (const Database::WorkedEntry &entry : entries) {
+            lines.append(QString("%1: %2 %3 - %4 QSO, ultimo %5")
+                         .arg(entry.logbook, entry.band, entry.mode)
+                         .arg(entry.count)
+                         .arg(QDateTime::fromSecsSinceEpoch(entry.lastEpoch, QTimeZone::utc()).toString("yyyy-MM-dd hh:mm")));
+        }
+        
+        QMessageBox::information(this, "Cerca in tutti i logbook",
+                               QString("%1 lavorato:\n\n%2").arg(callsign, lines.join("\n")));
+    });
+    watcher->setFuture(m_asyncDatabase->read<QList<Database::WorkedEntry>>(AsyncDatabase::NormalPriority,
+        [callsign, logbooks](Database &database) {
+            return database.workedBeforeAcrossLogbooks(callsign, logbooks);
+        }));
+}
+
+void MainWindow::onCrossLogStatistics()
+{
+    const QStringList logbooks = Database::knownLogbooks();
+    QFutureWatcher<Database::LogbookStatistics> *watcher = new QFutureWatcher<Database::LogbookStatistics>(this);
+    connect(watcher, &QFutureWatcher<Database::LogbookStatistics>::finished, this, [this, watcher, logbooks]() {
+        const Database::LogbookStatistics statistics = watcher->result();
+        watcher->deleteLater();
+        
+        QStringList bands;
+        for (auto it = statistics.bandCounts.constBegin(); it != statistics.bandCounts.constEnd(); ++it) {
+            bands.append(QString("%1: %2").arg(it.key()).arg(it.value()));
+        }
+        
+        QStringList modes;
+        for (auto it = statistics.modeCounts.constBegin(); it != statistics.modeCounts.constEnd(); ++it) {
+            modes.append(QString("%1: %2").arg(it.key()).arg(it.value()));
+        }
+        
+        QMessageBox::information(this, "Statistiche di tutti i logbook",
+                               QString("Logbook: %1\n"
+                                      "Contatti totali: %2\n"
+                                      "DXCC: %3\n\n"
+                                      "Bande:\n%4\n\n"
+                                      "Modi:\n%5")
+                               .arg(qMax(logbooks.size(), 1))
+                               .arg(statistics.totalContacts)
+                               .arg(statistics.dxccCounts.size())
+                               .arg(bands.join("\n"), modes.join("\n")));
+    });
+    watcher->setFuture(m_asyncDatabase->read<Database::LogbookStatistics>(AsyncDatabase::NormalPriority,
+        [logbooks](Database &database) {
+            return database.getStatisticsAcrossLogbooks(logbooks);
+        }));
+}
+
+void MainWindow::onQueryDiagnostics()
+{
+    // Occupazione del file e profilo delle query di tutte le connessioni
+    // (GUI, scrittura, pool di lettura): istogrammi per istruzione e
+    // registro delle query lente
+    QDialog dialog(this);
+    dialog.setWindowTitle("Diagnostica database");
+    dialog.resize(900, 600);
+    
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    QPlainTextEdit *reportEdit = new QPlainTextEdit(&dialog);
+    reportEdit->setReadOnly(true);
+    reportEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
+    reportEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    reportEdit->setAccessibleName("Rapporto diagnostica database");
+    layout->addWidget(reportEdit);
+    
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, &dialog);
+    buttonBox->button(QDialogButtonBox::Close)->setText("Chiudi");
+    QPushButton *refreshButton = buttonBox->addButton("Aggiorna", QDialogButtonBox::ActionRole);
+    QPushButton *resetButton = buttonBox->addButton("Azzera", QDialogButtonBox::ResetRole);
+    QPushButton *compactButton = buttonBox->addButton("Compatta", QDialogButtonBox::ActionRole);
+    QPushButton *saveButton = buttonBox->addButton("Salva...", QDialogButtonBox::ActionRole);
+    layout->addWidget(buttonBox);
+    
+    // La misura della frammentazione scorre contacts_data: dal pool di lettura
+    auto refresh = [this, reportEdit]() {
+        reportEdit->setPlainText(QueryProfiler::instance().dump(100));
+        
+        QFutureWatcher<Database::StorageStatistics> *watcher = new QFutureWatcher<Database::StorageStatistics>(reportEdit);
+        connect(watcher, &QFutureWatcher<Database::StorageStatistics>::finished, reportEdit, [reportEdit, watcher]() {
+            const Database::StorageStatistics storage = watcher->result();
+            watcher->deleteLater();
+            
+            const QStringList autoVacuumNames = {"disattivato", "completo", "incrementale"};
+            QStringList lines;
+            lines.append(QString("Database - %1 pagine da %2 byte, libere %3 (%4%), auto_vacuum %5")
+                         .arg(storage.pageCount).arg(storage.pageSize).arg(storage.freelistCount)
+                         .arg(storage.freelistRatio() * 100.0, 0, 'f', 1)
+                         .arg(autoVacuumNames.value(storage.autoVacuum)));
+            lines.append(storage.fragmentation < 0
+                         ? QString("Frammentazione contacts_data: non misurabile (modulo dbstat assente)")
+                         : QString("Frammentazione contacts_data: %1% pagine fuori sequenza")
+                           .arg(storage.fragmentation * 100.0, 0, 'f', 1));
+            lines.append(storage.analyzedRows < 0
+                         ? QString("Statistiche ottimizzatore: mai calcolate")
+                         : QString("Statistiche ottimizzatore: %1 righe analizzate, %2 attuali (scostamento %3%)")
+                           .arg(storage.analyzedRows).arg(storage.currentRows)
+                           .arg(storage.statisticsDrift() * 100.0, 0, 'f', 1));
+            lines.append(QString());
+            
+            reportEdit->setPlainText(lines.join("\n") + QueryProfiler::instance().dump(100));
+        });
+        watcher->setFuture(m_asyncDatabase->read<Database::StorageStatistics>(AsyncDatabase::NormalPriority,
+            [](Database &database) {
+                return database.storageStatistics(true);
+            }));
+    };
+    
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    connect(refreshButton, &QPushButton::clicked, &dialog, refresh);
+    connect(compactButton, &QPushButton::clicked, &dialog, [this, compactButton, refresh]() {
+        compactButton->setEnabled(false);
+        QFutureWatcher<int> *watcher = new QFutureWatcher<int>(compactButton);
+        connect(watcher, &QFutureWatcher<int>::finished, compactButton, [compactButton, watcher, refresh]() {
+            watcher->deleteLater();
+            compactButton->setEnabled(true);
+            refresh();
+        });
+        watcher->setFuture(m_asyncDatabase->compactDatabase());
+    });
+    connect(resetButton, &QPushButton::clicked, &dialog, [refresh]() {
+        QueryProfiler::instance().reset();
+        refresh();
+    });
+    connect(saveButton, &QPushButton::clicked, &dialog, [&dialog, reportEdit]() {
+        const QString fileName = QFileDialog::getSaveFileName(&dialog, "Salva rapporto",
+            QString("query_%1.txt").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")),
+            "File di testo (*.txt)");
+        if (fileName.isEmpty()) {
+            return;
+        }
+        
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            QMessageBox::warning(&dialog, "Errore", "Impossibile scrivere il file:\n" + file.errorString());
+            return;
+        }
+        QTextStream(&file) << reportEdit->toPlainText() << "\n";
+    });
+    
+    refresh();
+    dialog.exec();
+}
+
+void MainWindow::runScheduledBackup()
+{
+    if (m_backup->isRunning()) {
+        return;
+    }
+    
+    const QString databasePath = m_database->databasePath();
+    const QDateTime lastBackup = DatabaseBackup::lastRotatingBackupTime(databasePath);
+    if (lastBackup.isValid() && lastBackup.secsTo(QDateTime::currentDateTime()) < BackupIntervalSeconds) {
+        return;
     }
+    
+    connect(m_backup, &DatabaseBackup::finished, this, [this, databasePath](bool success, const QString &error) {
+        if (!success) {
+            qWarning() << "Backup automatico fallito:" << error;
+            statusBar()->showMessage("Backup automatico fallito: " + error, 10000);
+            return;
+        }
+        
+        DatabaseBackup::pruneRotatingBackups(databasePath);
+        statusBar()->showMessage("Backup automatico completato", 5000);
+    }, Qt::SingleShotConnection);
+    
+    m_backup->start(DatabaseBackup::rotatingBackupPath(databasePath));
+}
+
+void MainWindow::runIdleMaintenance()
+{
+    // Con richieste in coda l'utente sta lavorando: si riprova più tardi
+    if (m_maintenanceRunning || m_asyncDatabase->pendingRequests() > 0) {
+        m_maintenanceTimer->start(MaintenanceIdleMs);
+        return;
+    }
+    
+    m_maintenanceRunning = true;
+    QFutureWatcher<int> *watcher = new QFutureWatcher<int>(this);
+    connect(watcher, &QFutureWatcher<int>::finished, this, [this, watcher]() {
+        const int freedPages = watcher->result();
+        watcher->deleteLater();
+        m_maintenanceRunning = false;
+        
+        if (freedPages > 0) {
+            statusBar()->showMessage(QString("Manutenzione database: liberate %1 pagine").arg(freedPages), 5000);
+        }
+        m_maintenanceTimer->start(MaintenanceIntervalMs);
+    });
+    watcher->setFuture(m_asyncDatabase->compactDatabase());
+}
+
+void MainWindow::onDatabaseError(const QString &error)
+{
+    QMessageBox::critical(this, "Errore", "Errore durante l'operazione sul database:\n" + error);
 }
 
 void MainWindow::onClearForm()
@@ -418,6 +1129,8 @@ void MainWindow::onCallsignTextEdited(const QString &text)
     // Ripristina i segnali
     m_callsignEdit->blockSignals(false);
     
+    updateCallsignCompleter(upperText);
+    
     // Trigger del lookup se il nominativo è abbastanza lungo
     if (upperText.length() >= 3) {
         m_apiService->lookupCallsign(upperText);
@@ -427,6 +1140,63 @@ void MainWindow::onCallsignTextEdited(const QString &text)
     }
 }
 
+void MainWindow::updateCallsignCompleter(const QString &text)
+{
+    // Corrispondenze parziali, poi i quasi uguali in corsivo; in grassetto
+    // i nominativi già presenti nel logbook
+    m_callsignCompleterModel->clear();
+    
+    const QList<SuperCheckPartial::Match> matches = m_superCheck.lookup(text);
+    for (const SuperCheckPartial::Match &match : matches) {
+        QStandardItem *item = new QStandardItem(match.callsign);
+        QFont font = item->font();
+        font.setBold(match.inLog);
+        font.setItalic(match.nearMiss);
+        item->setFont(font);
+        
+        QString description = match.nearMiss ? "Quasi uguale (un carattere di differenza)" : "Corrispondenza parziale";
+        if (match.inLog) {
+            description += ", già nel logbook";
+        }
+        item->setToolTip(description);
+        item->setData(match.callsign + ", " + description, Qt::AccessibleTextRole);
+        m_callsignCompleterModel->appendRow(item);
+    }
+}
+
+void MainWindow::loadSuperCheckList(const QString &fileName)
+{
+    QString error;
+    if (!m_superCheck.loadMasterFile(fileName, &error)) {
+        qWarning() << "Lista Super Check Partial non caricata:" << error;
+        statusBar()->showMessage("Lista Super Check Partial non caricata: " + error, 5000);
+        return;
+    }
+    
+    statusBar()->showMessage(QString("Lista Super Check Partial: %1 nominativi").arg(m_superCheck.masterSize()), 5000);
+}
+
+void MainWindow::onLoadSuperCheckList()
+{
+    QSettings settings;
+    const QString fileName = QFileDialog::getOpenFileName(this, "Carica lista Super Check Partial",
+        settings.value("supercheck/masterFile").toString(),
+        "Liste SCP (*.scp *.SCP *.txt);;Tutti i file (*)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    QString error;
+    if (!m_superCheck.loadMasterFile(fileName, &error)) {
+        QMessageBox::critical(this, "Errore Super Check Partial", "Impossibile caricare la lista:\n" + error);
+        return;
+    }
+    
+    settings.setValue("supercheck/masterFile", fileName);
+    QMessageBox::information(this, "Super Check Partial",
+                             QString("Lista caricata: %1 nominativi.").arg(m_superCheck.masterSize()));
+}
+
 void MainWindow::onCallsignChanged()
 {
     QString callsign = m_callsignEdit->text().toUpper();
@@ -595,13 +1365,15 @@ void MainWindow::onSettings()
     settingsDialog.setApiCredentials(dialogApiCredentials);
     
     if (settingsDialog.exec() == QDialog::Accepted) {
-        // Salva i dati dell'operatore
+        // Salva i dati dell'operatore nel thread database: con un nuovo
+        // locatore la stessa transazione ricalcola la distanza di ogni QSO
         SettingsDialog::OperatorData newOperatorData = settingsDialog.getOperatorData();
-        if (!m_database->setOperatorData(newOperatorData.callsign, newOperatorData.firstName,
-                                       newOperatorData.lastName, newOperatorData.locator)) {
-            QMessageBox::warning(this, "Avviso", 
-                                "Impossibile salvare i dati dell'operatore. Errore: " + m_database->lastError());
-        }
+        Database::OperatorData savedOperatorData;
+        savedOperatorData.callsign = newOperatorData.callsign;
+        savedOperatorData.firstName = newOperatorData.firstName;
+        savedOperatorData.lastName = newOperatorData.lastName;
+        savedOperatorData.locator = newOperatorData.locator;
+        m_asyncDatabase->setOperatorData(savedOperatorData); // errori segnalati da onDatabaseError
         
         // Salva le credenziali API
         SettingsDialog::ApiCredentials newApiCredentials = settingsDialog.getApiCredentials();
@@ -660,17 +1432,285 @@ void MainWindow::showValidationError(const QString &message)
 
 void MainWindow::updateContactsTable()
 {
-    QList<Contact> contacts = m_database->getAllContacts();
-    m_contactsModel->setContacts(contacts);
+    // Chiede al database solo le modifiche successive all'ultimo refresh;
+    // la ricarica completa resta per il primo avvio e i cambi massivi
+    Database::ContactChanges changes = m_database->getContactChangesSince(m_contactsWatermark);
+    
+    // Un contatto già nel modello è stato modificato, non inserito
+    bool modified = false;
+    for (const Contact &contact : std::as_const(changes.upserted)) {
+        if (m_contactsModel->containsContact(contact.id())) {
+            modified = true;
+            break;
+        }
+    }
+    
+    if (changes.fullReloadRequired) {
+        m_contactsModel->setContacts(m_database->getAllCompactContacts());
+        // I QSO non ancora scritti restano visibili con l'id provvisorio
+        m_contactsModel->applyChanges(m_writeQueue->pendingContacts(), QList<int>());
+        reloadAwards();
+    } else {
+        applyContactChanges(changes.upserted, changes.removedIds);
+    }
+    m_contactsWatermark = changes.watermark;
+    
+    // L'indice dei duplicati segue gli inserimenti; cancellazioni, modifiche e
+    // ricariche complete possono spostare il primo o l'ultimo QSO di un gruppo,
+    // quindi si ricostruisce
+    if (changes.fullReloadRequired || modified || !changes.removedIds.isEmpty()) {
+        reloadDupeIndex();
+    } else {
+        for (const Contact &contact : changes.upserted) {
+            m_dupeIndex.add(contact);
+            m_superCheck.addCallsign(contact.callsign(), SuperCheckPartial::LogSource);
+        }
+        updateDupeStatus();
+    }
     
     // Aggiorna la status bar
-    int totalContacts = contacts.size();
+    int totalContacts = m_contactsModel->contactCount();
     statusBar()->showMessage(QString("Contatti totali: %1").arg(totalContacts));
     
     // Aggiorna il campo operatore
     m_operatorEdit->setText(m_database->getOperatorCall());
 }
 
+void MainWindow::applyContactChanges(const QList<Contact> &upserted, const QList<int> &removedIds)
+{
+    // I diplomi tolgono la versione precedente, letta dal modello prima che
+    // cambi, e aggiungono la nuova
+    Contact previous;
+    for (const Contact &contact : upserted) {
+        if (m_contactsModel->findContact(contact.id(), &previous)) {
+            m_awards.remove(previous);
+        }
+        m_awards.add(contact);
+    }
+    if (m_awardsLoading && !upserted.isEmpty()) {
+        m_awardsStale = true;
+    }
+    
+    m_contactsModel->applyChanges(upserted, removedIds);
+    
+    // Un QSO sparito dal database principale può essere stato archiviato e
+    // contare ancora: come per l'indice dei duplicati si ricarica
+    // l'aggregato, che comprende gli archivi
+    if (!removedIds.isEmpty()) {
+        reloadAwards();
+    }
+}
+
+void MainWindow::reloadAwards()
+{
+    if (m_awardsLoading) {
+        m_awardsStale = true;
+        return;
+    }
+    m_awardsLoading = true;
+    m_awardsStale = false;
+    
+    QFutureWatcher<QList<Database::AwardSummary>> *watcher = new QFutureWatcher<QList<Database::AwardSummary>>(this);
+    AsyncDatabase *source = m_asyncDatabase;
+    connect(watcher, &QFutureWatcher<QList<Database::AwardSummary>>::finished, this, [this, watcher, source]() {
+        watcher->deleteLater();
+        if (source != m_asyncDatabase) {
+            markSessionReload(source);
+            return;
+        }
+        
+        m_awards.load(watcher->result());
+        for (const Contact &contact : m_writeQueue->pendingContacts()) {
+            m_awards.add(contact);
+        }
+        
+        m_awardsLoading = false;
+        if (m_awardsStale) {
+            reloadAwards();
+        }
+        updateAwardStatus();
+    });
+    watcher->setFuture(m_asyncDatabase->read<QList<Database::AwardSummary>>(AsyncDatabase::NormalPriority,
+        [](Database &database) {
+            return database.getAwardSummaries();
+        }));
+}
+
+QString MainWindow::awardNoveltyText(AwardTracker::Award award, const QString &entity) const
+{
+    if (entity.isEmpty()) {
+        return QString();
+    }
+    
+    const QString name = award == AwardTracker::DxccAward ? "DXCC" : "quadrato";
+    switch (m_awards.novelty(award, entity, m_bandCombo->currentText(), m_modeCombo->currentText())) {
+    case AwardTracker::NewEntity:
+        return QString("NUOVO %1 %2").arg(name.toUpper(), entity);
+    case AwardTracker::NewBand:
+        return QString("%1 %2: nuova banda").arg(name, entity);
+    case AwardTracker::NewMode:
+        return QString("%1 %2: nuovo modo").arg(name, entity);
+    case AwardTracker::NewSlot:
+        return QString("%1 %2: nuova combinazione banda/modo").arg(name, entity);
+    case AwardTracker::NotNew:
+        break;
+    }
+    return QString();
+}
+
+void MainWindow::updateAwardStatus()
+{
+    // Qualche ricerca in tabella per entità: nessuna query durante il logging
+    QStringList messages;
+    const QString dxcc = awardNoveltyText(AwardTracker::DxccAward,
+        AwardTracker::entityFor(AwardTracker::DxccAward, m_dxccEdit->text(), QString()));
+    const QString grid = awardNoveltyText(AwardTracker::GridAward,
+        AwardTracker::entityFor(AwardTracker::GridAward, QString(), m_locatorEdit->text()));
+    if (!dxcc.isEmpty()) {
+        messages.append(dxcc);
+    }
+    if (!grid.isEmpty()) {
+        messages.append(grid);
+    }
+    
+    m_awardLabel->setText(messages.join(" - "));
+}
+
+void MainWindow::onAwards()
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle("Diplomi");
+    dialog.resize(900, 600);
+    
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    QComboBox *awardCombo = new QComboBox(&dialog);
+    awardCombo->setAccessibleName("Selezione diploma");
+    for (int award = 0; award < AwardTracker::AwardCount; ++award) {
+        awardCombo->addItem(AwardTracker::awardName(AwardTracker::Award(award)));
+    }
+    layout->addWidget(awardCombo);
+    
+    QLabel *summaryLabel = new QLabel(&dialog);
+    layout->addWidget(summaryLabel);
+    
+    // La matrice arriva dalle maschere in memoria: nessuna scansione dei QSO
+    AwardMatrixModel *matrixModel = new AwardMatrixModel(&dialog);
+    QTableView *matrixView = new QTableView(&dialog);
+    matrixView->setModel(matrixModel);
+    matrixView->setAccessibleName("Matrice del diploma per entità e banda");
+    matrixView->verticalHeader()->setVisible(false);
+    matrixView->verticalHeader()->setDefaultSectionSize(matrixView->fontMetrics().height() + 6);
+    layout->addWidget(matrixView);
+    
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, &dialog);
+    buttonBox->button(QDialogButtonBox::Close)->setText("Chiudi");
+    layout->addWidget(buttonBox);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    
+    const auto showAward = [this, matrixModel, summaryLabel, matrixView](int index) {
+        const AwardTracker::Award award = AwardTracker::Award(index);
+        matrixModel->setMatrix(m_awards.matrix(award), m_awards.bands());
+        matrixView->resizeColumnToContents(AwardMatrixModel::ColumnEntity);
+        summaryLabel->setText(QString("%1: %2 lavorati").arg(AwardTracker::awardName(award)).arg(m_awards.workedCount(award)));
+    };
+    connect(awardCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), &dialog, showAward);
+    showAward(awardCombo->currentIndex());
+    
+    dialog.exec();
+}
+
+void MainWindow::reloadDupeIndex()
+{
+    // Il riepilogo viene letto dal pool in sola lettura per non bloccare la GUI
+    QFutureWatcher<QList<Database::DupeSummary>> *watcher = new QFutureWatcher<QList<Database::DupeSummary>>(this);
+    AsyncDatabase *source = m_asyncDatabase;
+    connect(watcher, &QFutureWatcher<QList<Database::DupeSummary>>::finished, this, [this, watcher, source]() {
+        watcher->deleteLater();
+        if (source != m_asyncDatabase) {
+            markSessionReload(source);
+            return;
+        }
+        
+        m_dupeIndex.load(watcher->result());
+        for (const Contact &contact : m_writeQueue->pendingContacts()) {
+            m_dupeIndex.add(contact);
+        }
+        m_superCheck.setLogCallsigns(m_dupeIndex.callsigns());
+        updateDupeStatus();
+    });
+    watcher->setFuture(m_asyncDatabase->read<QList<Database::DupeSummary>>(AsyncDatabase::NormalPriority,
+        [](Database &database) {
+            return database.getDupeSummaries();
+        }));
+}
+
+void MainWindow::updateDupeStatus()
+{
+    updateWorkedStatus();
+    updateAwardStatus();
+    
+    const QString callsign = m_callsignEdit->text().trimmed();
+    qint64 lastEpoch = 0;
+    
+    if (callsign.isEmpty()
+        || !m_dupeIndex.isDupe(callsign, m_bandCombo->currentText(), m_modeCombo->currentText(),
+                               DupeWindowSeconds, QDateTime::currentSecsSinceEpoch(), &lastEpoch)) {
+        m_dupeLabel->clear();
+        return;
+    }
+    
+    QString message = "DUPE";
+    if (lastEpoch != Contact::InvalidEpoch) {
+        message += " (" + QDateTime::fromSecsSinceEpoch(lastEpoch, QTimeZone::utc()).toString("yyyy-MM-dd hh:mm") + ")";
+    }
+    m_dupeLabel->setText(message);
+}
+
+void MainWindow::updateWorkedStatus()
+{
+    // Solo l'indice in memoria: nessuna query a ogni tasto
+    const QString callsign = m_callsignEdit->text().trimmed();
+    if (callsign.length() < 3) {
+        m_workedLabel->clear();
+        return;
+    }
+    
+    const DupeIndex::WorkedBefore worked = m_dupeIndex.workedBefore(callsign, m_bandCombo->currentText(),
+                                                                    m_modeCombo->currentText());
+    if (!worked.worked) {
+        m_workedLabel->setText("Nuovo nominativo");
+        return;
+    }
+    
+    QStringList parts;
+    if (worked.lastEpoch != Contact::InvalidEpoch) {
+        const QString format = "yyyy-MM-dd hh:mm";
+        const QString last = QDateTime::fromSecsSinceEpoch(worked.lastEpoch, QTimeZone::utc()).toString(format);
+        if (worked.firstEpoch != Contact::InvalidEpoch && worked.firstEpoch != worked.lastEpoch) {
+            parts.append(QString("Lavorato dal %1, ultimo %2")
+                         .arg(QDateTime::fromSecsSinceEpoch(worked.firstEpoch, QTimeZone::utc()).toString(format), last));
+        } else {
+            parts.append("Lavorato il " + last);
+        }
+    } else {
+        parts.append("Già lavorato");
+    }
+    parts.append("Bande: " + worked.bands.join(" "));
+    parts.append("Modi: " + worked.modes.join(" "));
+    
+    if (worked.newBand && worked.newMode) {
+        parts.append("NUOVA BANDA E NUOVO MODO");
+    } else if (worked.newBand) {
+        parts.append("NUOVA BANDA");
+    } else if (worked.newMode) {
+        parts.append("NUOVO MODO");
+    } else if (worked.newSlot) {
+        parts.append("NUOVA COMBINAZIONE BANDA/MODO");
+    }
+    
+    m_workedLabel->setText(parts.join(" - "));
+}
+
 void MainWindow::configureApiService()
 {
     Database::ApiCredentials credentials = m_database->getApiCredentials();
@@ -747,7 +1787,7 @@ void MainWindow::onImportADIF()
     }
     
     // Ottieni tutti i contatti esistenti per il controllo duplicati
-    QList<Contact> existingContacts = m_database->getAllContacts();
+    QList<CompactContact> existingContacts = m_database->getAllCompactContacts();
     
     // Importa i contatti
     ADIFHandler::ImportResult result = adifHandler.importFromFile(fileName, existingContacts);
@@ -758,16 +1798,11 @@ void MainWindow::onImportADIF()
         return;
     }
     
-    // Aggiungi i contatti importati al database
-    int importedCount = 0;
+    // Imposta l'operatore corrente se non specificato
+    const QString operatorCall = m_database->getOperatorCall();
     for (Contact &contact : result.importedContacts) {
-        // Imposta l'operatore corrente se non specificato
         if (contact.operatorCall().isEmpty()) {
-            contact.setOperatorCall(m_database->getOperatorCall());
-        }
-        
-        if (m_database->addContact(contact)) {
-            importedCount++;
+            contact.setOperatorCall(operatorCall);
         }
     }
     
@@ -778,24 +1813,35 @@ void MainWindow::onImportADIF()
         
         if (!duplicateReportPath.isEmpty()) {
             adifHandler.generateDuplicateReport(duplicateReportPath, result.duplicateContacts, 
-                                               m_database->getOperatorCall());
+                                               operatorCall);
         }
     }
     
-    // Aggiorna la tabella
-    updateContactsTable();
+    // Aggiungi i contatti importati al database in background, in una sola
+    // transazione: un inserimento interattivo ha comunque la precedenza
+    const int totalRecords = result.totalRecords;
+    const int duplicatesFound = result.duplicatesFound;
     
-    // Mostra risultato
-    QString message = QString("Importazione completata:\n\n")
-                     + QString("Record totali: %1\n").arg(result.totalRecords)
-                     + QString("Contatti importati: %1\n").arg(importedCount)
-                     + QString("Duplicati trovati: %1").arg(result.duplicatesFound);
-    
-    if (result.duplicatesFound > 0) {
-        message += QString("\n\nI duplicati sono stati salvati nel report DupeImport.adi");
-    }
+    QFutureWatcher<int> *watcher = new QFutureWatcher<int>(this);
+    connect(watcher, &QFutureWatcher<int>::finished, this, [this, watcher, totalRecords, duplicatesFound]() {
+        const int importedCount = watcher->result();
+        watcher->deleteLater();
+        
+        // Mostra risultato
+        QString message = QString("Importazione completata:\n\n")
+                         + QString("Record totali: %1\n").arg(totalRecords)
+                         + QString("Contatti importati: %1\n").arg(importedCount)
+                         + QString("Duplicati trovati: %1").arg(duplicatesFound);
+        
+        if (duplicatesFound > 0) {
+            message += QString("\n\nI duplicati sono stati salvati nel report DupeImport.adi");
+        }
+        
+        QMessageBox::information(this, "Importazione ADIF", message);
+    });
+    watcher->setFuture(m_asyncDatabase->addContacts(result.importedContacts, fileName));
     
-    QMessageBox::information(this, "Importazione ADIF", message);
+    statusBar()->showMessage(QString("Importazione di %1 contatti in corso...").arg(result.importedContacts.size()));
 }
 
 void MainWindow::onExportADIF()
@@ -807,29 +1853,47 @@ void MainWindow::onExportADIF()
         return;
     }
     
-    // Ottieni tutti i contatti
-    QList<Contact> contacts = m_database->getAllContacts();
-    
-    if (contacts.isEmpty()) {
-        QMessageBox::information(this, "Esportazione ADIF", 
-                               "Nessun contatto da esportare.");
-        return;
-    }
-    
-    ADIFHandler adifHandler;
-    ADIFHandler::ExportResult result = adifHandler.exportToFile(fileName, contacts, 
-                                                               m_database->getOperatorCall());
-    
-    if (!result.success) {
-        QMessageBox::critical(this, "Errore Esportazione", 
-                             "Errore durante l'esportazione:\n" + result.errorMessage);
-        return;
-    }
-    
-    QString message = QString("Esportazione completata:\n\n")
-                     + QString("Contatti totali: %1\n").arg(result.totalRecords)
-                     + QString("Contatti esportati: %1\n").arg(result.successfulExports)
-                     + QString("\nFile salvato: %1").arg(fileName);
-    
-    QMessageBox::information(this, "Esportazione ADIF", message);
+    // Lettura e scrittura del file avvengono su una connessione del pool in
+    // sola lettura, in background: il logging può continuare nel frattempo
+    const QString operatorCall = m_database->getOperatorCall();
+    QFuture<ADIFHandler::ExportResult> future = m_asyncDatabase->read<ADIFHandler::ExportResult>(
+        AsyncDatabase::BackgroundPriority, [fileName, operatorCall](Database &database) {
+        ADIFHandler::ExportResult result;
+        
+        // Ottieni tutti i contatti, compresi quelli negli archivi annuali
+        QList<Contact> contacts = database.queryContacts(ContactQuery().setIncludeArchives(true));
+        if (contacts.isEmpty()) {
+            result.success = true;
+            return result;
+        }
+        
+        ADIFHandler adifHandler;
+        return adifHandler.exportToFile(fileName, contacts, operatorCall);
+    });
+    
+    QFutureWatcher<ADIFHandler::ExportResult> *watcher = new QFutureWatcher<ADIFHandler::ExportResult>(this);
+    connect(watcher, &QFutureWatcher<ADIFHandler::ExportResult>::finished, this, [this, watcher, fileName]() {
+        const ADIFHandler::ExportResult result = watcher->result();
+        watcher->deleteLater();
+        
+        if (!result.success) {
+            QMessageBox::critical(this, "Errore Esportazione", 
+                                 "Errore durante l'esportazione:\n" + result.errorMessage);
+            return;
+        }
+        
+        if (result.totalRecords == 0) {
+            QMessageBox::information(this, "Esportazione ADIF", 
+                                   "Nessun contatto da esportare.");
+            return;
+        }
+        
+        QString message = QString("Esportazione completata:\n\n")
+                         + QString("Contatti totali: %1\n").arg(result.totalRecords)
+                         + QString("Contatti esportati: %1\n").arg(result.successfulExports)
+                         + QString("\nFile salvato: %1").arg(fileName);
+        
+        QMessageBox::information(this, "Esportazione ADIF", message);
+    });
+    watcher->setFuture(future);
 }
\ No newline at end of file
@@ -24,19 +24,28 @@
 #include <QGridLayout>
 #include <QStatusBar>
 #include <QMenuBar>
+#include <QMenu>
 #include <QAction>
 #include <QApplication>
 #include <QGuiApplication>
 #include <QScreen>
 #include <QOverload>
 #include <QTableView>
+#include <QCompleter>
+#include <QStandardItemModel>
 
 #include "database.h"
+#include "asyncdatabase.h"
 #include "apiservice.h"
 #include "contact.h"
 #include "logbookmodel.h"
 #include "settingsdialog.h"
 #include "adifhandler.h"
+#include "dupeindex.h"
+#include "databasebackup.h"
+#include "qsowritequeue.h"
+#include "supercheckpartial.h"
+#include "awardtracker.h"
 
 class MainWindow : public QMainWindow
 {
@@ -59,6 +68,22 @@ private slots:
     void onSettings();
     void onImportADIF();
     void onExportADIF();
+    void onBackupDatabase();
+    void onRestoreDatabase();
+    void onArchiveContacts();
+    void updateLogbookMenu();
+    void onNewLogbook();
+    void onOpenLogbook();
+    void onCrossLogSearch();
+    void onCrossLogStatistics();
+    void onQueryDiagnostics();
+    void onLoadSuperCheckList();
+    void onAwards();
+    void runScheduledBackup();
+    void runIdleMaintenance();
+    void onDatabaseError(const QString &error);
+    void updateDupeStatus();
+    void updateAwardStatus();
 
 protected:
     void changeEvent(QEvent *event) override;
@@ -76,6 +101,22 @@ private:
     bool validateForm();
     void showValidationError(const QString &message);
     void updateContactsTable();
+    void reloadDupeIndex();
+    void updateWorkedStatus();
+    void reloadAwards();
+    void applyContactChanges(const QList<Contact> &upserted, const QList<int> &removedIds);
+    QString awardNoveltyText(AwardTracker::Award award, const QString &entity) const;
+    void loadSuperCheckList(const QString &fileName);
+    void updateCallsignCompleter(const QString &text);
+    void switchToLogbook(const QString &path);
+    // Ripristino: stopDatabaseServices() chiude il file, resetDatabaseServices()
+    // ricrea i servizi sul file sostituito
+    void stopDatabaseServices();
+    void resetDatabaseServices();
+    void markSessionReload(AsyncDatabase *source);
+    void createWriteQueue();
+    void removeTemporaryContacts(const QList<Contact> &contacts);
+    void updateWindowTitle();
     void configureApiService();
     void pauseTimerForAccessibility();
     void resumeTimerForAccessibility();
@@ -91,6 +132,8 @@ private:
     QLineEdit *m_dateTimeEdit;
     QLabel *m_callsignLabel;
     QLineEdit *m_callsignEdit;
+    QLabel *m_dupeLabel;
+    QLabel *m_workedLabel;
     QLabel *m_bandLabel;
     QComboBox *m_bandCombo;
     QLabel *m_modeLabel;
@@ -105,6 +148,7 @@ private:
     QLineEdit *m_dxccEdit;
     QLabel *m_locatorLabel;
     QLineEdit *m_locatorEdit;
+    QLabel *m_awardLabel;
     QLabel *m_operatorLabel;
     QLineEdit *m_operatorEdit;
     
@@ -115,11 +159,64 @@ private:
     // Table
     QTableView *m_contactsTable;
     LogbookModel *m_contactsModel;
+    qint64 m_contactsWatermark = -1; // ultimo stato del database applicato al modello
+    
+    // Controllo duplicati: stesso nominativo, banda e modo entro la finestra
+    // (48 ore, la durata dei contest più lunghi)
+    static constexpr qint64 DupeWindowSeconds = 48 * 3600;
+    DupeIndex m_dupeIndex;
+    
+    // Super check partial: lista master più i nominativi del logbook,
+    // corrispondenze mostrate nel completer sotto il nominativo
+    SuperCheckPartial m_superCheck;
+    
+    // Diplomi (DXCC, quadrati del locatore): caricati dalla query aggregata,
+    // poi aggiornati contatto per contatto. Le modifiche arrivate durante il
+    // caricamento asincrono fanno ripetere la lettura
+    AwardTracker m_awards;
+    bool m_awardsLoading = false;
+    bool m_awardsStale = false;
+    QCompleter *m_callsignCompleter;
+    QStandardItemModel *m_callsignCompleterModel;
     
     // Services
     Database *m_database;
+    AsyncDatabase *m_asyncDatabase;
+    QsoWriteQueue *m_writeQueue;    // va svuotata prima di fermare m_asyncDatabase: stopDatabaseServices()
     ApiService *m_apiService;
     
+    // Servizi e stato dei logbook aperti ma non attivi. Al cambio di logbook
+    // quello lasciato conserva thread database, pool di lettura, modello,
+    // indice dei duplicati e diplomi: il ritorno non rilancia le migrazioni
+    // e recupera solo le modifiche dal registro
+    struct LogbookSession {
+        AsyncDatabase *asyncDatabase = nullptr;
+        QsoWriteQueue *writeQueue = nullptr;
+        DatabaseBackup *backup = nullptr;
+        LogbookModel *contactsModel = nullptr;
+        qint64 contactsWatermark = -1;
+        DupeIndex dupeIndex;
+        AwardTracker awards;
+        bool reloadRequired = false;    // un caricamento è finito mentre era inattivo
+    };
+    QHash<QString, LogbookSession> m_sessions;  // per percorso assoluto del file
+    
+    // Backup automatico a rotazione: controllo ogni ora, nuova copia quando
+    // l'ultima ha più di un giorno. Dichiarato dopo i servizi: si costruisce
+    // dal percorso di m_database
+    static constexpr int BackupCheckIntervalMs = 3600 * 1000;
+    static constexpr qint64 BackupIntervalSeconds = 24 * 3600;
+    DatabaseBackup *m_backup;
+    QTimer *m_backupTimer;
+    
+    // Compattazione e statistiche dell'ottimizzatore a logging fermo: parte
+    // due minuti dopo l'ultima modifica del nominativo (il timer riparte a
+    // ogni tasto), senza attività si ripete ogni mezz'ora
+    static constexpr int MaintenanceIdleMs = 2 * 60 * 1000;
+    static constexpr int MaintenanceIntervalMs = 30 * 60 * 1000;
+    QTimer *m_maintenanceTimer;
+    bool m_maintenanceRunning = false;
+    
     // Timer for date/time updates
     QTimer *m_dateTimeTimer;
     
@@ -129,6 +226,15 @@ private:
     QAction *m_settingsAction;
     QAction *m_importADIFAction;
     QAction *m_exportADIFAction;
+    QAction *m_backupAction;
+    QAction *m_restoreAction;
+    QAction *m_archiveAction;
+    QAction *m_crossLogSearchAction;
+    QAction *m_crossLogStatisticsAction;
+    QAction *m_queryDiagnosticsAction;
+    QAction *m_superCheckAction;
+    QAction *m_awardsAction;
+    QMenu *m_logbookMenu;
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
@@ -0,0 +1,323 @@
+#include "qsowritequeue.h"
+#include "asyncdatabase.h"
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QSaveFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QDebug>
+
+QsoWriteQueue::QsoWriteQueue(AsyncDatabase *asyncDatabase, const QString &databasePath, QObject *parent)
+    : QObject(parent)
+    , m_asyncDatabase(asyncDatabase)
+{
+    m_journal.setFileName(journalPath(databasePath));
+    m_rejectedPath = rejectedPath(databasePath);
+    
+    m_flushTimer.setSingleShot(true);
+    connect(&m_flushTimer, &QTimer::timeout, this, &QsoWriteQueue::flush);
+    
+    // QSO rimasti nel journal da una sessione interrotta
+    loadJournal();
+    if (!m_pending.isEmpty()) {
+        qInfo() << "Recupero di" << m_pending.size() << "QSO dal journal" << m_journal.fileName();
+        m_flushTimer.start(0);
+    }
+}
+
+QsoWriteQueue::~QsoWriteQueue()
+{
+    drain();
+}
+
+QString QsoWriteQueue::journalPath(const QString &databasePath)
+{
+    return databasePath + ".qsoqueue";
+}
+
+QString QsoWriteQueue::rejectedPath(const QString &databasePath)
+{
+    return databasePath + ".qsorejected";
+}
+
+QByteArray QsoWriteQueue::journalLine(const Contact &contact)
+{
+    return QJsonDocument(contact.toJson()).toJson(QJsonDocument::Compact) + '\n';
+}
+
+Contact QsoWriteQueue::enqueue(const Contact &contact)
+{
+    Entry entry;
+    entry.contact = contact;
+    entry.contact.setId(m_nextTemporaryId--);
+    
+    // Una riga JSON in coda al file, consegnata al sistema operativo senza
+    // fsync: il QSO sopravvive alla chiusura anomala dell'applicazione, la
+    // durabilità su disco arriva con il commit SQLite entro FlushIntervalMs
+    if (!m_journal.isOpen() && !m_journal.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Impossibile aprire il journal dei QSO:" << m_journal.errorString();
+    }
+    if (m_journal.isOpen()) {
+        m_journal.write(journalLine(entry.contact));
+        m_journal.flush();
+    }
+    
+    m_pending.append(entry);
+    if (m_writing.isEmpty() && !m_flushTimer.isActive()) {
+        m_flushTimer.start(FlushIntervalMs);
+    }
+    
+    return entry.contact;
+}
+
+QList<Contact> QsoWriteQueue::pendingContacts() const
+{
+    QList<Contact> contacts;
+    contacts.reserve(pendingCount());
+    for (const Entry &entry : m_writing) {
+        contacts.append(entry.contact);
+    }
+    for (const Entry &entry : m_pending) {
+        contacts.append(entry.contact);
+    }
+    return contacts;
+}
+
+void QsoWriteQueue::flush()
+{
+    // Un solo gruppo alla volta sul thread database
+    if (!m_writing.isEmpty() || m_pending.isEmpty()) {
+        return;
+    }
+    
+    const int count = qMin<int>(m_pending.size(), MaxBatchSize);
+    m_writing = m_pending.mid(0, count);
+    m_pending.remove(0, count);
+    m_writeFuture = writeBatch(m_writing);
+    
+    const quint64 generation = m_generation;
+    QFutureWatcher<FlushResult> *watcher = new QFutureWatcher<FlushResult>(this);
+    connect(watcher, &QFutureWatcher<FlushResult>::finished, this, [this, watcher, generation]() {
+        watcher->deleteLater();
+        if (generation != m_generation) {
+            return; // già gestito da drain()
+        }
+        
+        const FlushResult result = watcher->result();
+        QList<Contact> rejected;
+        const QList<Contact> written = applyResult(result, &rejected);
+        if (!written.isEmpty()) {
+            emit flushed(written);
+        }
+        for (const Contact &contact : std::as_const(rejected)) {
+            emit contactRejected(contact, result.error);
+        }
+        
+        if (!m_writing.isEmpty() || m_pending.isEmpty()) {
+            return;
+        }
+        if (written.isEmpty()) {
+            // Nessun QSO scritto: si riprova più tardi, il journal li conserva
+            emit flushFailed(result.error);
+            m_flushTimer.start(RetryIntervalMs);
+        } else {
+            m_flushTimer.start(FlushIntervalMs);
+        }
+    });
+    watcher->setFuture(m_writeFuture);
+}
+
+QFuture<QsoWriteQueue::FlushResult> QsoWriteQueue::writeBatch(const QList<Entry> &batch)
+{
+    return m_asyncDatabase->run<FlushResult>(AsyncDatabase::InteractivePriority, [batch](Database &database) {
+        FlushResult result;
+        QList<Contact> contacts;
+        QList<int> positions;
+        
+        for (int i = 0; i < batch.size(); ++i) {
+            const Entry &entry = batch.at(i);
+            result.ids.append(-1);
+            
+            // Un QSO riletto dal journal può essere già stato scritto se
+            // l'interruzione è arrivata tra il commit e l'aggiornamento del file
+            if (entry.recovered && !database.findDuplicates(entry.contact, 0).isEmpty()) {
+                result.ids[i] = 0;
+                continue;
+            }
+            
+            Contact contact = entry.contact;
+            contact.setId(-1);
+            contacts.append(contact);
+            positions.append(i);
+        }
+        
+        if (contacts.isEmpty()) {
+            return result;
+        }
+        
+        // Una transazione per tutto il gruppo; con il commit fallito gli id
+        // assegnati non valgono e l'intero gruppo resta in coda
+        if (database.addContacts(contacts) == 0) {
+            result.error = database.lastError();
+            return result;
+        }
+        
+        for (int i = 0; i < contacts.size(); ++i) {
+            if (contacts.at(i).id() > 0) {
+                result.ids[positions.at(i)] = contacts.at(i).id();
+            } else if (result.error.isEmpty()) {
+                result.error = database.lastError();
+            }
+        }
+        return result;
+    });
+}
+
+QList<Contact> QsoWriteQueue::applyResult(const FlushResult &result, QList<Contact> *rejected)
+{
+    QList<Contact> written;
+    QList<int> failedPositions;
+    for (int i = 0; i < m_writing.size(); ++i) {
+        const int id = i < result.ids.size() ? result.ids.at(i) : -1;
+        if (id >= 0) {
+            written.append(m_writing.at(i).contact);
+        } else {
+            failedPositions.append(i);
+        }
+    }
+    
+    // Il tentativo conta solo se l'errore è del QSO: con il resto del gruppo
+    // scritto, o da solo nel gruppo. Un gruppo intero non scritto indica il
+    // database non disponibile e non consuma i tentativi dei singoli QSO
+    const bool countAttempt = !written.isEmpty() || m_writing.size() == 1;
+    QList<Entry> failed;
+    QList<Entry> discarded;
+    for (int i : std::as_const(failedPositions)) {
+        Entry entry = m_writing.at(i);
+        if (countAttempt) {
+            entry.attempts++;
+        }
+        if (entry.attempts < MaxAttempts) {
+            failed.append(entry);
+        } else {
+            discarded.append(entry);
+            if (rejected) {
+                rejected->append(entry.contact);
+            }
+        }
+    }
+    
+    if (!failed.isEmpty()) {
+        qWarning() << "QSO non scritti, restano in coda:" << failed.size() << result.error;
+    }
+    if (!discarded.isEmpty()) {
+        qWarning() << "QSO scartati dopo" << MaxAttempts << "tentativi:" << discarded.size() << result.error;
+        appendRejected(discarded);
+    }
+    
+    // I QSO non scritti tornano in testa, nell'ordine di inserimento
+    m_writing.clear();
+    m_pending = failed + m_pending;
+    rewriteJournal();
+    
+    return written;
+}
+
+QList<Contact> QsoWriteQueue::drain()
+{
+    m_flushTimer.stop();
+    
+    // Il completamento del gruppo in volo viene gestito qui, non dal watcher
+    QList<Contact> written;
+    m_generation++;
+    if (!m_writing.isEmpty()) {
+        m_writeFuture.waitForFinished();
+        written.append(applyResult(m_writeFuture.result()));
+    }
+    
+    while (!m_pending.isEmpty()) {
+        const int count = qMin<int>(m_pending.size(), MaxBatchSize);
+        m_writing = m_pending.mid(0, count);
+        m_pending.remove(0, count);
+        m_writeFuture = writeBatch(m_writing);
+        m_writeFuture.waitForFinished();
+        
+        // Database non scrivibile: i QSO restano nel journal per il prossimo avvio
+        const QList<Contact> batch = applyResult(m_writeFuture.result());
+        if (batch.isEmpty()) {
+            break;
+        }
+        written.append(batch);
+    }
+    
+    return written;
+}
+
+void QsoWriteQueue::appendRejected(const QList<Entry> &entries)
+{
+    // Il QSO esce dal journal ma non va perso: resta da reinserire a mano
+    QFile file(m_rejectedPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Impossibile salvare i QSO scartati:" << file.errorString();
+        return;
+    }
+    for (const Entry &entry : entries) {
+        file.write(journalLine(entry.contact));
+    }
+}
+
+void QsoWriteQueue::loadJournal()
+{
+    QFile file(m_journal.fileName());
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        
+        // L'ultima riga può essere troncata da un'interruzione durante la scrittura
+        QJsonParseError parseError;
+        const QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+        if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+            qWarning() << "Riga del journal dei QSO non leggibile:" << parseError.errorString();
+            continue;
+        }
+        
+        Entry entry;
+        entry.contact.fromJson(document.object());
+        entry.contact.setId(m_nextTemporaryId--);
+        entry.recovered = true;
+        m_pending.append(entry);
+    }
+}
+
+void QsoWriteQueue::rewriteJournal()
+{
+    // Il file contiene esattamente i QSO ancora da scrivere; la sostituzione
+    // atomica lascia intatto il journal precedente se la scrittura fallisce
+    m_journal.close();
+    
+    if (m_writing.isEmpty() && m_pending.isEmpty()) {
+        if (m_journal.exists() && !m_journal.remove()) {
+            qWarning() << "Impossibile rimuovere il journal dei QSO:" << m_journal.errorString();
+        }
+        return;
+    }
+    
+    QSaveFile file(m_journal.fileName());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Impossibile riscrivere il journal dei QSO:" << file.errorString();
+        return;
+    }
+    for (const Entry &entry : std::as_const(m_writing)) {
+        file.write(journalLine(entry.contact));
+    }
+    for (const Entry &entry : std::as_const(m_pending)) {
+        file.write(journalLine(entry.contact));
+    }
+    if (!file.commit()) {
+        qWarning() << "Impossibile riscrivere il journal dei QSO:" << file.errorString();
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef QSOWRITEQUEUE_H
+#define QSOWRITEQUEUE_H
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QList>
+#include <QtCore/QFile>
+#include <QtCore/QFuture>
+#include <QtCore/QTimer>
+
+#include "contact.h"
+
+class AsyncDatabase;
+
+// Coda write-behind per il logging a ritmo di contest. Il QSO riceve un id
+// provvisorio negativo, entra subito nel modello e viene aggiunto in coda a un
+// journal su file; il thread database scrive la coda a gruppi, in una sola
+// transazione, ogni FlushIntervalMs. Se l'applicazione si interrompe, alla
+// creazione successiva della coda il journal viene riletto e i QSO non ancora
+// presenti nel database vengono scritti.
+class QsoWriteQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int FlushIntervalMs = 250;
+    static constexpr int MaxBatchSize = 500;
+    static constexpr int RetryIntervalMs = 5000;    // dopo un gruppo non scritto
+    static constexpr int MaxAttempts = 5;           // poi il QSO viene scartato
+    
+    QsoWriteQueue(AsyncDatabase *asyncDatabase, const QString &databasePath, QObject *parent = nullptr);
+    ~QsoWriteQueue();   // scrive quanto resta (drain)
+    
+    // Restituisce il contatto con l'id provvisorio usato nel modello
+    Contact enqueue(const Contact &contact);
+    // QSO in coda o in scrittura, con id provvisorio
+    QList<Contact> pendingContacts() const;
+    int pendingCount() const { return m_pending.size() + m_writing.size(); }
+    
+    // Scrive subito tutta la coda e attende il thread database. Da chiamare
+    // prima di fermare l'AsyncDatabase (ripristino, uscita) o di lasciare il
+    // logbook; restituisce i QSO scritti, con l'id provvisorio, senza flushed()
+    QList<Contact> drain();
+    
+    static QString journalPath(const QString &databasePath);
+    // QSO scartati dopo MaxAttempts scritture fallite, una riga JSON ciascuno
+    static QString rejectedPath(const QString &databasePath);
+
+signals:
+    // QSO scritti, con l'id provvisorio: le righe provvisorie lasciano il
+    // posto a quelle notificate dal registro delle modifiche
+    void flushed(const QList<Contact> &contacts);
+    void flushFailed(const QString &error);
+    // QSO tolto dalla coda dopo MaxAttempts tentativi, con l'id provvisorio;
+    // resta nel file rejectedPath()
+    void contactRejected(const Contact &contact, const QString &error);
+
+private:
+    struct Entry {
+        Contact contact;
+        bool recovered = false;     // riletto dal journal: può essere già nel database
+        int attempts = 0;           // scritture fallite finora
+    };
+    struct FlushResult {
+        QList<int> ids;             // id definitivo, 0 = già presente, -1 = non scritto
+        QString error;
+    };
+    
+    void flush();
+    QFuture<FlushResult> writeBatch(const QList<Entry> &batch);
+    // Rimette in coda i QSO non scritti, restituisce quelli scritti; rejected
+    // riceve quelli che hanno esaurito i tentativi
+    QList<Contact> applyResult(const FlushResult &result, QList<Contact> *rejected = nullptr);
+    void appendRejected(const QList<Entry> &entries);
+    void loadJournal();
+    void rewriteJournal();
+    static QByteArray journalLine(const Contact &contact);
+    
+    AsyncDatabase *m_asyncDatabase;
+    QFile m_journal;
+    QString m_rejectedPath;
+    QTimer m_flushTimer;
+    QList<Entry> m_pending;
+    QList<Entry> m_writing;         // gruppo affidato al thread database
+    QFuture<FlushResult> m_writeFuture;
+    quint64 m_generation = 0;       // scarta i completamenti superati da drain()
+    int m_nextTemporaryId = -2;     // -1 è "nessun id" in Contact
+};
+
+#endif // QSOWRITEQUEUE_H
@@ -0,0 +1,263 @@
+#include "queryprofiler.h"
+#include <QtCore/QMutexLocker>
+#include <QtCore/QMetaType>
+#include <QtCore/QDebug>
+#include <algorithm>
+
+qint64 QueryProfiler::StatementStats::percentileMicros(double percentile) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    
+    const double target = double(count) * percentile / 100.0;
+    quint64 cumulative = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        cumulative += buckets[i];
+        if (double(cumulative) >= target) {
+            return qMin(qint64(1) << (i + 1), maxMicros);
+        }
+    }
+    
+    return maxMicros;
+}
+
+QueryProfiler::QueryProfiler()
+    : m_enabled(true)
+    , m_slowThresholdMicros(DefaultSlowThresholdMicros)
+{
+    m_otherStatements.sql = "(altre istruzioni)";
+}
+
+QueryProfiler &QueryProfiler::instance()
+{
+    static QueryProfiler profiler;
+    return profiler;
+}
+
+void QueryProfiler::setEnabled(bool enabled)
+{
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void QueryProfiler::setSlowThresholdMicros(qint64 micros)
+{
+    m_slowThresholdMicros.store(qMax<qint64>(micros, 0), std::memory_order_relaxed);
+}
+
+int QueryProfiler::bucketFor(qint64 micros)
+{
+    int bucket = 0;
+    while (micros > 1 && bucket < BucketCount - 1) {
+        micros >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+bool QueryProfiler::record(const QString &sql, qint64 micros)
+{
+    const bool slow = micros >= slowThresholdMicros();
+    
+    QMutexLocker locker(&m_mutex);
+    auto it = m_statements.find(sql);
+    if (it == m_statements.end()) {
+        if (m_statements.size() < MaxStatements) {
+            it = m_statements.insert(sql, StatementStats());
+            it->sql = sql.simplified();
+        }
+    }
+    
+    StatementStats &stats = it != m_statements.end() ? it.value() : m_otherStatements;
+    stats.count++;
+    stats.totalMicros += micros;
+    stats.maxMicros = qMax(stats.maxMicros, micros);
+    stats.buckets[bucketFor(micros)]++;
+    if (slow) {
+        stats.slowCount++;
+    }
+    
+    return slow;
+}
+
+bool QueryProfiler::needsPlan(const QString &sql) const
+{
+    if (!isExplainable(sql)) {
+        return false;
+    }
+    
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_statements.constFind(sql);
+    return it != m_statements.constEnd() && it->plan.isEmpty();
+}
+
+void QueryProfiler::recordSlow(const QString &sql, qint64 micros, const QString &connection,
+                               const QString &parameterShape, const QStringList &plan)
+{
+    SlowQuery slowQuery;
+    slowQuery.timestamp = QDateTime::currentDateTime();
+    slowQuery.connection = connection;
+    slowQuery.sql = sql.simplified();
+    slowQuery.parameterShape = parameterShape;
+    slowQuery.micros = micros;
+    
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_statements.find(sql);
+        if (it != m_statements.end()) {
+            if (it->plan.isEmpty()) {
+                it->plan = plan;
+            }
+            slowQuery.plan = it->plan;
+        }
+        
+        m_slowQueries.prepend(slowQuery);
+        if (m_slowQueries.size() > MaxSlowQueries) {
+            m_slowQueries.removeLast();
+        }
+    }
+    
+    qWarning().noquote() << QString("Query lenta (%1, %2): %3 parametri %4")
+        .arg(formatMicros(micros), connection.isEmpty() ? QString("predefinita") : connection,
+             slowQuery.sql, parameterShape);
+    for (const QString &step : std::as_const(slowQuery.plan)) {
+        qWarning().noquote() << "    piano:" << step;
+    }
+}
+
+QList<QueryProfiler::StatementStats> QueryProfiler::statementStats() const
+{
+    QList<StatementStats> statements;
+    {
+        QMutexLocker locker(&m_mutex);
+        statements = m_statements.values();
+        if (m_otherStatements.count > 0) {
+            statements.append(m_otherStatements);
+        }
+    }
+    
+    std::sort(statements.begin(), statements.end(), [](const StatementStats &a, const StatementStats &b) {
+        return a.totalMicros > b.totalMicros;
+    });
+    return statements;
+}
+
+QList<QueryProfiler::SlowQuery> QueryProfiler::slowQueries() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_slowQueries;
+}
+
+void QueryProfiler::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_statements.clear();
+    m_otherStatements = StatementStats();
+    m_otherStatements.sql = "(altre istruzioni)";
+    m_slowQueries.clear();
+}
+
+QString QueryProfiler::parameterShape(const QVariantList &values)
+{
+    QStringList types;
+    for (const QVariant &value : values) {
+        if (value.isNull()) {
+            types.append("null");
+            continue;
+        }
+        
+        switch (value.metaType().id()) {
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+        case QMetaType::Bool:
+            types.append("int");
+            break;
+        case QMetaType::Double:
+            types.append("real");
+            break;
+        case QMetaType::QByteArray:
+            types.append(QString("blob(%1)").arg(value.toByteArray().size()));
+            break;
+        case QMetaType::QString:
+            types.append(QString("text(%1)").arg(value.toString().size()));
+            break;
+        default:
+            types.append(value.metaType().name());
+            break;
+        }
+    }
+    
+    return "[" + types.join(", ") + "]";
+}
+
+bool QueryProfiler::isExplainable(const QString &sql)
+{
+    // Solo le istruzioni con un piano: niente PRAGMA, BEGIN, ATTACH, DDL
+    const QString head = sql.trimmed().section(' ', 0, 0).toUpper();
+    return head == "SELECT" || head == "WITH" || head == "INSERT" || head == "UPDATE"
+        || head == "DELETE" || head == "REPLACE";
+}
+
+QString QueryProfiler::formatMicros(qint64 micros)
+{
+    if (micros >= 1000) {
+        return QString("%1 ms").arg(double(micros) / 1000.0, 0, 'f', 1);
+    }
+    return QString("%1 µs").arg(micros);
+}
+
+QString QueryProfiler::dump(int maxStatements) const
+{
+    const QList<StatementStats> statements = statementStats();
+    const QList<SlowQuery> slow = slowQueries();
+    
+    QStringList lines;
+    lines.append(QString("Profilo query SQL - soglia query lente: %1").arg(formatMicros(slowThresholdMicros())));
+    lines.append(QString());
+    lines.append("esecuzioni     totale      media        p50        p95        p99        max  lente  istruzione");
+    
+    for (int i = 0; i < statements.size() && i < maxStatements; ++i) {
+        const StatementStats &stats = statements.at(i);
+        lines.append(QString("%1 %2 %3 %4 %5 %6 %7 %8  %9")
+                     .arg(stats.count, 10)
+                     .arg(formatMicros(stats.totalMicros), 10)
+                     .arg(formatMicros(qint64(stats.averageMicros())), 10)
+                     .arg(formatMicros(stats.percentileMicros(50)), 10)
+                     .arg(formatMicros(stats.percentileMicros(95)), 10)
+                     .arg(formatMicros(stats.percentileMicros(99)), 10)
+                     .arg(formatMicros(stats.maxMicros), 10)
+                     .arg(stats.slowCount, 6)
+                     .arg(stats.sql.left(200)));
+        
+        // Istogramma compatto: solo i bucket non vuoti
+        QStringList histogram;
+        for (int bucket = 0; bucket < BucketCount; ++bucket) {
+            if (stats.buckets[bucket] > 0) {
+                histogram.append(QString("<%1: %2").arg(formatMicros(qint64(1) << (bucket + 1))).arg(stats.buckets[bucket]));
+            }
+        }
+        lines.append("           " + histogram.join("  "));
+    }
+    
+    if (statements.size() > maxStatements) {
+        lines.append(QString("... altre %1 istruzioni").arg(statements.size() - maxStatements));
+    }
+    
+    lines.append(QString());
+    lines.append(QString("Query lente registrate: %1").arg(slow.size()));
+    for (const SlowQuery &query : slow) {
+        lines.append(QString());
+        lines.append(QString("%1  %2  [%3]")
+                     .arg(query.timestamp.toString("yyyy-MM-dd hh:mm:ss"), formatMicros(query.micros),
+                          query.connection.isEmpty() ? QString("predefinita") : query.connection));
+        lines.append("  " + query.sql.left(500));
+        lines.append("  parametri: " + query.parameterShape);
+        for (const QString &step : query.plan) {
+            lines.append("  piano: " + step);
+        }
+    }
+    
+    return lines.join("\n");
+}
@@ -0,0 +1,91 @@
+#ifndef QUERYPROFILER_H
+#define QUERYPROFILER_H
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QList>
+#include <QtCore/QHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QVariant>
+#include <QtCore/QMutex>
+#include <atomic>
+
+// Profilo delle istruzioni SQL eseguite da Database: per ogni istruzione un
+// istogramma delle latenze e, oltre la soglia, un registro delle query lente
+// con la forma dei parametri (tipi, non valori) e il piano di esecuzione.
+// Unico per il processo: lo alimentano tutte le connessioni, da ogni thread.
+class QueryProfiler
+{
+public:
+    static constexpr int BucketCount = 24;                      // potenze di 2 in µs: fino a ~8 s
+    static constexpr qint64 DefaultSlowThresholdMicros = 20000; // 20 ms, più di un frame della GUI
+    static constexpr int MaxSlowQueries = 200;
+    static constexpr int MaxStatements = 1000;
+    
+    struct StatementStats {
+        QString sql;
+        quint64 count = 0;
+        quint64 slowCount = 0;
+        qint64 totalMicros = 0;
+        qint64 maxMicros = 0;
+        quint64 buckets[BucketCount] = {};  // bucket i: latenze in [2^i, 2^(i+1)) µs
+        QStringList plan;                   // EXPLAIN QUERY PLAN della prima esecuzione lenta
+        
+        double averageMicros() const
+        {
+            return count > 0 ? double(totalMicros) / double(count) : 0.0;
+        }
+        // Limite superiore del bucket che contiene il percentile (0-100)
+        qint64 percentileMicros(double percentile) const;
+    };
+    
+    struct SlowQuery {
+        QDateTime timestamp;
+        QString connection;
+        QString sql;
+        QString parameterShape;
+        qint64 micros = 0;
+        QStringList plan;
+    };
+    
+    static QueryProfiler &instance();
+    
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled);
+    qint64 slowThresholdMicros() const { return m_slowThresholdMicros.load(std::memory_order_relaxed); }
+    void setSlowThresholdMicros(qint64 micros);
+    
+    // Registra un'esecuzione; true se è più lenta della soglia
+    bool record(const QString &sql, qint64 micros);
+    // Il piano serve solo alla prima esecuzione lenta di ogni istruzione
+    bool needsPlan(const QString &sql) const;
+    void recordSlow(const QString &sql, qint64 micros, const QString &connection,
+                    const QString &parameterShape, const QStringList &plan);
+    
+    QList<StatementStats> statementStats() const;   // per tempo totale decrescente
+    QList<SlowQuery> slowQueries() const;           // dalla più recente
+    void reset();
+    
+    // Rapporto testuale per il pannello diagnostica e per --query-stats
+    QString dump(int maxStatements = 30) const;
+    
+    // Tipi dei parametri associati, es. "[int, text(6), null]"
+    static QString parameterShape(const QVariantList &values);
+    static bool isExplainable(const QString &sql);
+
+private:
+    QueryProfiler();
+    
+    static int bucketFor(qint64 micros);
+    static QString formatMicros(qint64 micros);
+    
+    std::atomic<bool> m_enabled;
+    std::atomic<qint64> m_slowThresholdMicros;
+    
+    mutable QMutex m_mutex;
+    QHash<QString, StatementStats> m_statements;    // per testo SQL originale
+    StatementStats m_otherStatements;               // oltre MaxStatements istruzioni distinte
+    QList<SlowQuery> m_slowQueries;
+};
+
+#endif // QUERYPROFILER_H
@@ -14,11 +14,14 @@
 #include <QtWidgets/QGroupBox>
 #include <QtWidgets/QInputDialog>
 #include <QtWidgets/QApplication>
+#include <QtWidgets/QProgressDialog>
 #include <QtCore/QDateTime>
 #include <QtCore/QRegularExpression>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QEventLoop>
 #include <QtGui/QRegularExpressionValidator>
-#include "adifhandler.h"
+#include "databasebackup.h"
 
 SettingsDialog::SettingsDialog(QWidget *parent)
     : QDialog(parent)
@@ -73,36 +76,55 @@ bool SettingsDialog::createBackupBeforeReset()
 {
     QString fileName = QFileDialog::getSaveFileName(this,
         "Salva Backup Database", 
-        QString("backup_logbook_%1.adi").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")),
-        "File ADIF (*.adi *.adif);;Tutti i file (*)");
+        QString("%1/backup_logbook_%2.db")
+            .arg(DatabaseBackup::backupDirectory(),
+                 QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")),
+        "Database SQLite (*.db);;Tutti i file (*)");
     
     if (fileName.isEmpty()) {
         return false; // Utente ha annullato
     }
     
-    Database *db = Database::instance();
-    QList<Contact> contacts = db->getAllContacts();
-    
-    if (contacts.isEmpty()) {
-        QMessageBox::information(this, "Backup", "Nessun contatto da salvare nel backup.");
-        return true;
-    }
-    
-    ADIFHandler adifHandler;
-    ADIFHandler::ExportResult result = adifHandler.exportToFile(fileName, contacts, db->getOperatorCall());
-    
-    if (!result.success) {
+    // Copia nativa del file (contatti e impostazioni) in un thread separato:
+    // il dialogo di avanzamento resta reattivo e permette di annullare
+    DatabaseBackup backup(Database::instance()->databasePath());
+    
+    QProgressDialog progressDialog("Backup del database in corso...", "Annulla", 0, 100, this);
+    progressDialog.setWindowTitle("Backup Database");
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.setMinimumDuration(0);
+    progressDialog.setValue(0);
+    
+    bool success = false;
+    QString errorMessage;
+    QEventLoop loop;
+    
+    connect(&backup, &DatabaseBackup::progress, &progressDialog, [&progressDialog](int copiedPages, int totalPages) {
+        progressDialog.setValue(totalPages > 0 ? copiedPages * 100 / totalPages : 0);
+    });
+    connect(&backup, &DatabaseBackup::finished, &loop, [&](bool ok, const QString &error) {
+        success = ok;
+        errorMessage = error;
+        loop.quit();
+    });
+    connect(&progressDialog, &QProgressDialog::canceled, &backup, &DatabaseBackup::cancel);
+    
+    backup.start(fileName);
+    loop.exec();
+    progressDialog.reset();
+    
+    if (!success) {
         QMessageBox::critical(this, "Errore Backup", 
-                             "Errore durante la creazione del backup:\n" + result.errorMessage);
+                             "Errore durante la creazione del backup:\n" + errorMessage);
         return false;
     }
     
     QMessageBox::information(this, "Backup Completato", 
                            QString("Backup creato con successo:\n\n"
                                   "File: %1\n"
-                                  "Contatti salvati: %2")
+                                  "Dimensione: %2 KB")
                                   .arg(fileName)
-                                  .arg(result.successfulExports));
+                                  .arg(QFileInfo(fileName).size() / 1024));
     
     return true;
 }
@@ -512,7 +534,7 @@ bool SettingsDialog::confirmReset()
         if (contactCount > 0) {
             int backupResult = QMessageBox::question(this, "Backup Database",
                 QString("Il database contiene %1 contatti.\n\n"
-                       "Vuoi creare un backup in formato ADIF prima di cancellare tutto?")
+                       "Vuoi creare un backup del database prima di cancellare tutto?")
                        .arg(contactCount),
                 QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel,
                 QMessageBox::Yes);
@@ -0,0 +1,340 @@
+#include "supercheckpartial.h"
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+#include <QtCore/QDebug>
+#include <algorithm>
+
+SuperCheckPartial::SuperCheckPartial()
+{
+}
+
+QString SuperCheckPartial::normalize(const QString &callsign)
+{
+    // Solo lettere, cifre e barra: gli n-grammi stanno in un byte per carattere
+    const QString upper = callsign.trimmed().toUpper();
+    for (const QChar c : upper) {
+        const char16_t code = c.unicode();
+        if (!((code >= u'A' && code <= u'Z') || (code >= u'0' && code <= u'9') || code == u'/')) {
+            return QString();
+        }
+    }
+    return upper;
+}
+
+quint32 SuperCheckPartial::gramKey(const QString &text, int position, int length)
+{
+    // Lunghezza negli 8 bit alti: bigrammi e trigrammi non collidono
+    quint32 key = quint32(length) << 24;
+    for (int i = 0; i < length; ++i) {
+        key |= quint32(text.at(position + i).unicode() & 0xFF) << (8 * (length - 1 - i));
+    }
+    return key;
+}
+
+bool SuperCheckPartial::loadMasterFile(const QString &fileName, QString *errorMessage)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (errorMessage) {
+            *errorMessage = QString("Impossibile aprire %1: %2").arg(fileName, file.errorString());
+        }
+        return false;
+    }
+    
+    clearSource(MasterSource);
+    
+    // Un nominativo per riga; le righe che iniziano con # sono commenti
+    QTextStream stream(&file);
+    QString line;
+    while (stream.readLineInto(&line)) {
+        if (line.startsWith('#')) {
+            continue;
+        }
+        addCallsign(line.section(' ', 0, 0, QString::SectionSkipEmpty), MasterSource);
+    }
+    
+    qInfo() << "Lista Super Check Partial caricata:" << m_masterCount << "nominativi da" << fileName;
+    return true;
+}
+
+void SuperCheckPartial::setLogCallsigns(const QStringList &callsigns)
+{
+    clearSource(LogSource);
+    for (const QString &callsign : callsigns) {
+        addCallsign(callsign, LogSource);
+    }
+}
+
+void SuperCheckPartial::addCallsign(const QString &callsign, Source source)
+{
+    const QString normalized = normalize(callsign);
+    if (normalized.size() < MinPartialLength) {
+        return;
+    }
+    
+    const auto it = m_entryByCallsign.constFind(normalized);
+    if (it != m_entryByCallsign.constEnd()) {
+        Entry &entry = m_entries[it.value()];
+        if (entry.sources == 0) {
+            m_callsignCount++;
+        }
+        if (source == MasterSource && !(entry.sources & MasterSource)) {
+            m_masterCount++;
+        }
+        entry.sources |= source;
+        return;
+    }
+    
+    const int index = m_entries.size();
+    m_entries.append(Entry{normalized, quint8(source)});
+    m_entryByCallsign.insert(normalized, index);
+    m_callsignCount++;
+    if (source == MasterSource) {
+        m_masterCount++;
+    }
+    
+    // Gli indici crescono: un n-gramma ripetuto nello stesso nominativo
+    // si riconosce dall'ultimo elemento dell'elenco
+    for (int length = 2; length <= 3; ++length) {
+        for (int i = 0; i + length <= normalized.size(); ++i) {
+            QList<int> &posting = m_postings[gramKey(normalized, i, length)];
+            if (posting.isEmpty() || posting.last() != index) {
+                posting.append(index);
+            }
+        }
+    }
+}
+
+void SuperCheckPartial::clearSource(Source source)
+{
+    // Le voci restano nell'indice senza sorgente: un nominativo che ritorna
+    // (nuova lista master, cambio logbook) non duplica gli n-grammi
+    for (Entry &entry : m_entries) {
+        if (!(entry.sources & source)) {
+            continue;
+        }
+        entry.sources &= ~source;
+        if (entry.sources == 0) {
+            m_callsignCount--;
+        }
+    }
+    if (source == MasterSource) {
+        m_masterCount = 0;
+    }
+}
+
+void SuperCheckPartial::clear()
+{
+    m_entries.clear();
+    m_entryByCallsign.clear();
+    m_postings.clear();
+    m_callsignCount = 0;
+    m_masterCount = 0;
+}
+
+QList<SuperCheckPartial::Match> SuperCheckPartial::lookup(const QString &text) const
+{
+    QList<Match> matches = partialMatches(text);
+    matches.append(nearMisses(text));
+    return matches;
+}
+
+QList<SuperCheckPartial::Match> SuperCheckPartial::partialMatches(const QString &partial) const
+{
+    QList<Match> matches;
+    const QString pattern = normalize(partial);
+    if (pattern.size() < MinPartialLength) {
+        return matches;
+    }
+    
+    // L'elenco più corto tra gli n-grammi del frammento: ogni corrispondenza
+    // contiene tutti gli n-grammi, quindi sta anche in quell'elenco
+    const int length = qMin<int>(pattern.size(), 3);
+    const QList<int> *shortest = nullptr;
+    for (int i = 0; i + length <= pattern.size(); ++i) {
+        const auto it = m_postings.constFind(gramKey(pattern, i, length));
+        if (it == m_postings.constEnd()) {
+            return matches;
+        }
+        if (!shortest || it->size() < shortest->size()) {
+            shortest = &it.value();
+        }
+    }
+    
+    struct Candidate {
+        int entry;
+        int position;
+    };
+    QList<Candidate> candidates;
+    for (int index : *shortest) {
+        const Entry &entry = m_entries.at(index);
+        if (entry.sources == 0) {
+            continue;
+        }
+        const int position = entry.callsign.indexOf(pattern);
+        if (position >= 0) {
+            candidates.append(Candidate{index, position});
+        }
+    }
+    
+    // Prima i nominativi già nel logbook, poi le corrispondenze all'inizio,
+    // poi i nominativi più corti
+    const auto before = [this](const Candidate &a, const Candidate &b) {
+        const Entry &entryA = m_entries.at(a.entry);
+        const Entry &entryB = m_entries.at(b.entry);
+        const bool logA = entryA.sources & LogSource;
+        const bool logB = entryB.sources & LogSource;
+        if (logA != logB) {
+            return logA;
+        }
+        if ((a.position == 0) != (b.position == 0)) {
+            return a.position == 0;
+        }
+        if (entryA.callsign.size() != entryB.callsign.size()) {
+            return entryA.callsign.size() < entryB.callsign.size();
+        }
+        return entryA.callsign < entryB.callsign;
+    };
+    const int count = qMin<int>(candidates.size(), MaxMatches);
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), before);
+    
+    matches.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const Entry &entry = m_entries.at(candidates.at(i).entry);
+        matches.append(Match{entry.callsign, bool(entry.sources & LogSource), false});
+    }
+    return matches;
+}
+
+QList<SuperCheckPartial::Match> SuperCheckPartial::nearMisses(const QString &callsign) const
+{
+    QList<Match> matches;
+    const QString text = normalize(callsign);
+    if (text.size() < MinNearMissLength) {
+        return matches;
+    }
+    
+    // Lemma dei q-grammi: sostituzione, inserimento e cancellazione tolgono
+    // al più 2 bigrammi, lo scambio di due caratteri adiacenti 3 (IK2BAC e
+    // IK2ABC ne condividono solo 2). Un candidato ne condivide quindi almeno
+    // (lunghezza - 1) - 3 con il testo
+    const int threshold = qMax(0, text.size() - 4);
+    QHash<int, int> shared;
+    for (int i = 0; i + 2 <= text.size(); ++i) {
+        const auto it = m_postings.constFind(gramKey(text, i, 2));
+        if (it == m_postings.constEnd()) {
+            continue;
+        }
+        for (int index : it.value()) {
+            shared[index]++;
+        }
+    }
+    
+    QList<int> found;
+    for (auto it = shared.constBegin(); it != shared.constEnd(); ++it) {
+        if (it.value() < threshold) {
+            continue;
+        }
+        const Entry &entry = m_entries.at(it.key());
+        // Chi contiene il testo è già tra le corrispondenze parziali
+        if (entry.sources == 0 || entry.callsign.contains(text)) {
+            continue;
+        }
+        if (isWithinOneEdit(text, entry.callsign)) {
+            found.append(it.key());
+        }
+    }
+    
+    std::sort(found.begin(), found.end(), [this](int a, int b) {
+        const Entry &entryA = m_entries.at(a);
+        const Entry &entryB = m_entries.at(b);
+        const bool logA = entryA.sources & LogSource;
+        const bool logB = entryB.sources & LogSource;
+        if (logA != logB) {
+            return logA;
+        }
+        return entryA.callsign < entryB.callsign;
+    });
+    
+    for (int i = 0; i < found.size() && i < MaxNearMisses; ++i) {
+        const Entry &entry = m_entries.at(found.at(i));
+        matches.append(Match{entry.callsign, bool(entry.sources & LogSource), true});
+    }
+    return matches;
+}
+
+bool SuperCheckPartial::isWithinOneEdit(const QString &a, const QString &b)
+{
+    const int lengthA = a.size();
+    const int lengthB = b.size();
+    if (qAbs(lengthA - lengthB) > 1) {
+        return false;
+    }
+    
+    // Prefisso comune, poi il resto deve coincidere dopo una sola modifica
+    int prefix = 0;
+    while (prefix < lengthA && prefix < lengthB && a.at(prefix) == b.at(prefix)) {
+        prefix++;
+    }
+    if (prefix == lengthA && prefix == lengthB) {
+        return true;
+    }
+    
+    if (lengthA == lengthB) {
+        // Sostituzione
+        if (QStringView(a).mid(prefix + 1) == QStringView(b).mid(prefix + 1)) {
+            return true;
+        }
+        // Scambio di due caratteri adiacenti
+        return prefix + 1 < lengthA && a.at(prefix) == b.at(prefix + 1) && a.at(prefix + 1) == b.at(prefix)
+            && QStringView(a).mid(prefix + 2) == QStringView(b).mid(prefix + 2);
+    }
+    
+    // Inserimento o cancellazione: si salta un carattere del più lungo
+    if (lengthA > lengthB) {
+        return QStringView(a).mid(prefix + 1) == QStringView(b).mid(prefix);
+    }
+    return QStringView(a).mid(prefix) == QStringView(b).mid(prefix + 1);
+}
+
+bool SuperCheckPartial::selfCheck(QString *errorMessage)
+{
+    // Un caso per ciascun tipo di modifica: il filtro sui bigrammi non deve
+    // scartare nessun candidato che isWithinOneEdit accetterebbe
+    SuperCheckPartial index;
+    index.addCallsign("IK2ABC", MasterSource);
+    index.addCallsign("DL1XYZ", MasterSource);
+    
+    const struct {
+        const char *text;
+        const char *expected;
+        bool nearMiss;
+    } cases[] = {
+        {"2AB", "IK2ABC", false},       // frammento
+        {"IK2ABX", "IK2ABC", true},     // sostituzione
+        {"IK2AC", "IK2ABC", true},      // cancellazione
+        {"IK2ABBC", "IK2ABC", true},    // inserimento
+        {"IK2BAC", "IK2ABC", true},     // scambio di caratteri adiacenti
+        {"KI2ABC", "IK2ABC", true},     // scambio all'inizio
+        {"DL1XZY", "DL1XYZ", true}      // scambio alla fine
+    };
+    
+    for (const auto &check : cases) {
+        bool found = false;
+        const QList<Match> matches = index.lookup(check.text);
+        for (const Match &match : matches) {
+            if (match.callsign == check.expected && match.nearMiss == check.nearMiss) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            if (errorMessage) {
+                *errorMessage = QString("Super Check Partial: %1 non trova %2").arg(QString(check.text), QString(check.expected));
+            }
+            return false;
+        }
+    }
+    
+    return true;
+}
@@ -0,0 +1,73 @@
+#ifndef SUPERCHECKPARTIAL_H
+#define SUPERCHECKPARTIAL_H
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QList>
+#include <QtCore/QHash>
+
+// Ricerca "super check partial" per il logging in contest: un frammento del
+// nominativo (es. "2AB") trova IK2ABC nella lista master (formato MASTER.SCP)
+// e nei nominativi del logbook. Ogni nominativo è indicizzato per bigrammi e
+// trigrammi: la ricerca parte dall'elenco più corto tra gli n-grammi del
+// frammento e verifica solo quei candidati. Lo stesso indice dei bigrammi
+// filtra i "quasi uguali" a una modifica di distanza (errori di ricezione).
+class SuperCheckPartial
+{
+public:
+    static constexpr int MinPartialLength = 2;
+    static constexpr int MinNearMissLength = 4;  // sotto, il filtro sui bigrammi non garantisce nulla
+    static constexpr int MaxMatches = 20;
+    static constexpr int MaxNearMisses = 10;
+    
+    enum Source {
+        MasterSource = 0x1,
+        LogSource = 0x2
+    };
+    
+    struct Match {
+        QString callsign;
+        bool inLog = false;
+        bool nearMiss = false;  // a una modifica di distanza, non contiene il frammento
+    };
+    
+    SuperCheckPartial();
+    
+    // Sostituisce la lista master; i nominativi del logbook restano
+    bool loadMasterFile(const QString &fileName, QString *errorMessage = nullptr);
+    void setLogCallsigns(const QStringList &callsigns);
+    void addCallsign(const QString &callsign, Source source);
+    void clear();
+    int size() const { return m_callsignCount; }
+    int masterSize() const { return m_masterCount; }
+    
+    // Corrispondenze parziali ordinate (prima il logbook, poi prefisso, poi
+    // lunghezza) seguite dai quasi uguali al testo completo
+    QList<Match> lookup(const QString &text) const;
+    QList<Match> partialMatches(const QString &partial) const;
+    QList<Match> nearMisses(const QString &callsign) const;
+    
+    static QString normalize(const QString &callsign);
+    // Distanza di modifica al più 1: sostituzione, inserimento, cancellazione
+    // o scambio di due caratteri adiacenti
+    static bool isWithinOneEdit(const QString &a, const QString &b);
+    // Verifica interna di ricerca parziale e quasi uguali (--self-check)
+    static bool selfCheck(QString *errorMessage = nullptr);
+
+private:
+    struct Entry {
+        QString callsign;
+        quint8 sources = 0;     // combinazione di Source; 0 = rimosso
+    };
+    
+    static quint32 gramKey(const QString &text, int position, int length);
+    void clearSource(Source source);
+    
+    QList<Entry> m_entries;
+    QHash<QString, int> m_entryByCallsign;
+    QHash<quint32, QList<int>> m_postings;  // n-gramma -> indici in m_entries, crescenti
+    int m_callsignCount = 0;
+    int m_masterCount = 0;
+};
+
+#endif // SUPERCHECKPARTIAL_H